@@ -6,38 +6,221 @@
 
 #define MAX_SPRITE_NAME_LENGTH 32
 
+#define RSP_BUNDLE_VERSION 2
+
+#ifndef RSP_ANIMATION_FPS
+#define RSP_ANIMATION_FPS 12
+#endif
+
+#ifndef RSP_WATCH_INTERVAL
+#define RSP_WATCH_INTERVAL 0.5 // Seconds between checks where inotify isn't available
+#endif
+
+#ifndef RSP_MAX_BUNDLES
+#define RSP_MAX_BUNDLES 16 // Bundles that can be active at once
+#endif
+
+// NOTE: Sprite ids hold the active slot of their bundle above the sprite's
+// index, so anything from the first slot is the index on its own
+#define RSP_SPRITE_ID(slot, index) (((slot) << 16) | (index))
+#define RSP_SPRITE_SLOT(id)        ((id) >> 16)
+#define RSP_SPRITE_INDEX(id)       ((id) & 0xFFFF)
+
+// NOTE: Also the on disk layout of v2 bundles, keep it free of pointers and
+// implicit padding
 typedef struct Sprite {
     uint64_t hash;
 
     char name[MAX_SPRITE_NAME_LENGTH];
 
     uint16_t flags;
+    uint16_t page;
     Rectangle source;
     Vector2 origin;
 
+    Vector2 offset; // Transparent border trimmed from the top left
+    Vector2 size;   // Size before trimming
+
     struct {
-        Rectangle* frames;
+        uint32_t frames_index; // First frame in the bundle's frames
         uint16_t frames_count;
-    } animation; // Not used
+        uint16_t frames_speed; // Frames per second, 0 falls back to RSP_ANIMATION_FPS
+    } animation;
+
+    uint32_t reserved;
 } Sprite;
 
+// NOTE: Everything drawing a sprite needs and nothing else, built on load so
+// the draw path never touches the much larger Sprite
+typedef struct SpriteQuad {
+    Vector2 uv_min; // Source on its page in texture coordinates
+    Vector2 uv_max;
+    Vector2 size;   // Source size in pixels
+    Vector2 origin; // Origin less the trimmed offset
+    uint16_t page;
+    uint16_t flags;
+} SpriteQuad;
+
 typedef struct SpriteBundle {
     int id;
 
-    Texture2D atlas;
+    Texture2D* pages;
+    Vector2* page_sizes; // In pixels, known whether or not the page is uploaded
+    uint16_t pages_count;
 
-    Sprite* sprites;
+    Sprite* sprites; // Names, hashes & everything else kept for lookups
     uint16_t sprites_count;
+
+    SpriteQuad* quads; // One per sprite
+
+    Rectangle* frames;
+    uint32_t frames_count;
+
+    // Tables of v2 bundles, sprites & frames point straight into them. Bundles
+    // loaded from aligned memory leave this empty and use that memory instead
+    void* data;
+    size_t data_size;
+    int data_mapped;
+    int in_place; // Sprites (& frames) are the caller's, from LoadBundleFromMemory or LoadBundleBaked
+
+    // Pages, quads & the index, plus v1 sprites & frames, in one allocation
+    // sized once the counts are known
+    void* arena;
+
+    // Set while the table is an allocation of its own, v1 tables until they
+    // move into the arena and sprites copied on write from in place memory
+    int sprites_owned;
+    int frames_owned;
+
+    // Name lookup built on load, each slot is the top half of a sprite's hash
+    // above its id + 1, 0 marks an empty slot
+    uint64_t* index;
+    uint32_t index_bits;
+
+    void* job;      // Set while LoadBundleAsync is still working on it
+    void* deferred; // Set for bundles from LoadBundleDeferred, pages load when drawn
 } SpriteBundle;
 
+// -----------------------------------------------------------------------------
+// v2 bundle layout
+//
+// Everything is little endian and 8 byte aligned. The header is followed by
+// the section directory, each section points at a table somewhere further in
+// the file, page payloads are placed by the page table.
+// -----------------------------------------------------------------------------
+typedef struct SpriteBundleHeader {
+    char magic[4];         // "RSPX"
+    uint16_t legacy_count; // Always 0, v1 bundles kept their sprite count here
+    uint16_t version;
+    uint32_t header_size;
+    uint32_t sections_count;
+    uint64_t file_size;
+} SpriteBundleHeader;
+
+typedef struct SpriteBundleSection {
+    char tag[4]; // "SPRT" sprites, "FRMS" frames or "PAGE" pages
+    uint32_t count;
+    uint64_t offset;
+    uint64_t size;
+} SpriteBundleSection;
+
+typedef struct SpriteBundlePage {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t codec; // SpriteBundleCodec the payload is stored with
+    uint32_t reserved;
+} SpriteBundlePage;
+
+// NOTE: Everything but PNG decodes straight to R8G8B8A8 with no image library
+// involved, raw pages upload directly out of the file
+typedef enum SpriteBundleCodec {
+    BUNDLE_CODEC_PNG = 0,
+    BUNDLE_CODEC_LZ4 = 1, // LZ4 block of the raw pixels
+    BUNDLE_CODEC_QOI = 2,
+    BUNDLE_CODEC_RAW = 3,
+} SpriteBundleCodec;
+
+typedef struct SpriteInstance {
+    int id;
+    Vector2 position;
+    Vector2 scale;
+    float rotation;
+    Color colour;
+} SpriteInstance;
+
+// NOTE: DrawSprites writes 4 of these per instance, top left, bottom left,
+// bottom right then top right, which is the order rlgl takes quads in
+typedef struct SpriteVertex {
+    Vector2 position;
+    Vector2 texcoord;
+    Color colour;
+} SpriteVertex;
+
+typedef enum SpriteAnimationLoop {
+    ANIMATION_LOOP = 0,
+    ANIMATION_ONCE,      // Holds the last frame once played through
+    ANIMATION_PING_PONG, // Plays back to the start once it reaches the end
+} SpriteAnimationLoop;
+
+// NOTE: Uploads should fill in the size & format of the texture, what pages
+// take up towards the budget is worked out from them
+typedef Texture2D (*PageUploadCallback) (Image image);
+typedef void (*PageUnloadCallback) (Texture2D texture);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int GetSpriteId (const char* name);
+void GetSpriteIds (const char** names, int* ids, int count);
 void DrawSprite (int id, Vector2 position, Color colour);
 void DrawSpriteEx (int id, Vector2 position, Vector2 scale, float rotation, Color colour);
 
+// Draws every instance in order, instances sharing a page back to back go out
+// in one batch. Sorting them by page keeps it to one draw call per page
+void DrawSprites (const SpriteInstance* instances, size_t count);
+
+// The CPU half of DrawSprites, 4 vertices per instance. Instances that aren't
+// a sprite of an active bundle come out as zeroed quads. Only the sprite
+// tables are read, so it works without a window or any page uploaded
+void GenSpriteVertices (const SpriteInstance* instances, size_t count, SpriteVertex* vertices);
+
+// The texture half, the page each instance is drawn with or 0 when it isn't
+// drawn. Deferred pages are loaded on the way, the same as drawing them
+void GetSpriteTextures (const SpriteInstance* instances, size_t count, unsigned int* textures);
+
+// Sprites entirely outside the view are dropped before any vertices are made,
+// rotation & scale included. Views are in world space, the camera one covers
+// the screen as seen through the camera. Culling is off until a view is set
+void SetSpriteCullCamera (Camera2D camera);
+void SetSpriteCullRect (Rectangle view);
+void DisableSpriteCulling (void);
+
+// Copies the instances that overlap view into visible, in order, and returns
+// how many. Visible can be instances to cull in place
+size_t CullSprites (const SpriteInstance* instances, size_t count, Rectangle view, SpriteInstance* visible);
+
+// Animations are handles into a pool advanced all at once by
+// UpdateAnimations, frames are rects on the sprite's page drawn around its
+// origin. Playing a sprite that isn't animated returns -1
+int PlayAnimation (int id, float speed, SpriteAnimationLoop loop);
+void StopAnimation (int animation);
+void StopAllAnimations (void); // Also frees the pool
+void SetAnimationSpeed (int animation, float speed);
+int GetAnimationFrame (int animation);
+int IsAnimationFinished (int animation);
+
+void UpdateAnimations (float delta);
+void DrawAnimation (int animation, Vector2 position, Color colour);
+void DrawAnimationEx (int animation, Vector2 position, Vector2 scale, float rotation, Color colour);
+
+// The CPU half of DrawAnimationEx, the 4 vertices of the frame showing now.
+// Zeroed when the animation isn't playing, works without a window the same as
+// GenSpriteVertices
+void GenAnimationVertices (int animation, Vector2 position, Vector2 scale, float rotation, Color colour, SpriteVertex* vertices);
+
 Vector2 GetSpriteOrigin (int id);
 void SetSpriteOrigin (int id, Vector2 origin);
 
@@ -45,7 +228,53 @@ Vector2 GetSpriteSize (int id);
 const char* GetSpriteName (int id);
 
 SpriteBundle LoadBundle (const char* filename);
+
+// Takes the sprites from RSP_SPRITES in the bundle.h exported with the bundle
+// instead of reading them from the file, only frames & pages are loaded. The
+// table is used in place so it has to outlive the bundle, and has to come
+// from the same export
+SpriteBundle LoadBundleBaked (const char* filename, const Sprite* sprites, size_t count);
+
+// NOTE: Bundles loaded from memory keep pointing into it, so data has to
+// outlive the bundle. It is never written to.
+SpriteBundle LoadBundleFromMemory (const unsigned char* data, size_t size);
+
+// Reads & decodes on a worker thread, PollBundle uploads whatever pages are
+// ready. Polling returns 1 once loaded, 0 while still loading or -1 on failure
+SpriteBundle LoadBundleAsync (const char* filename);
+int PollBundle (SpriteBundle* bundle);
+
+// Loads everything but the pages, each page is decoded & uploaded the first
+// time something on it is drawn. The file is read again for every page, so it
+// has to stay where it is
+SpriteBundle LoadBundleDeferred (const char* filename);
+
+// Deferred pages drawn longest ago are unloaded whenever all pages together
+// would take up more than the budget, they load again when next drawn. Pages
+// loaded up front count towards it but are never unloaded. 0, the default,
+// never unloads anything
+void SetPageBudget (size_t bytes);
+size_t GetPageMemoryUsed (void);
+
+// Every page upload & unload goes through these, NULL puts back raylib's
+void SetPageUploadCallbacks (PageUploadCallback upload, PageUnloadCallback unload);
+
+// Reloads the bundle whenever filename changes, decoding on a worker thread,
+// or deferred again for bundles from LoadBundleDeferred. UpdateBundleWatches
+// swaps finished reloads in and returns how many, call it once a frame before
+// drawing. Sprites keep their ids across reloads, ones added get new ids &
+// removed ones draw nothing
+void WatchBundle (SpriteBundle* bundle, const char* filename);
+void UnwatchBundle (SpriteBundle* bundle);
+int UpdateBundleWatches (void);
+
+// Active bundles are looked up through the pointer, so they have to stay put
+// while active. GetSpriteId searches them in slot order. SetActiveBundle
+// makes the bundle the only active one in slot 0, NULL clears them all
 void SetActiveBundle (SpriteBundle* bundle);
+int AddActiveBundle (SpriteBundle* bundle); // Returns its slot, -1 when full
+void RemoveActiveBundle (SpriteBundle* bundle);
+
 int IsBundleReady (SpriteBundle bundle);
 
 void UnloadBundle (SpriteBundle bundle);
@@ -55,17 +284,112 @@ void UnloadBundle (SpriteBundle bundle);
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <float.h>
+#include <math.h>
+#include <rlgl.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if !defined(RSP_NO_THREADS)
+#include <pthread.h>
+#endif
 
 #define HEADER_SIZE 4
 
+#define RSP_DRAW_BATCH 256 // Instances turned into vertices at a time
+
 #define RSP_SPRITE_ANIMATED 1 << 0
 #define RSP_SPRITE_ORIGIN   1 << 1
+#define RSP_SPRITE_ROTATED  1 << 2
 
 // -----------------------------------------------------------------------------
 // PRIVATE DATA
 // -----------------------------------------------------------------------------
-static SpriteBundle* rsp__current_bundle = NULL;
-static int rsp__bundles_loaded           = 0;
+static SpriteBundle* rsp__active_bundles[RSP_MAX_BUNDLES] = {0};
+static int rsp__bundles_loaded                             = 0; // Never goes down, so no id is handed out twice
+
+static struct {
+    PageUploadCallback upload;
+    PageUnloadCallback unload;
+} rsp__page_callbacks = {0};
+
+static Rectangle rsp__cull_view = {0}; // World space, only used while culling
+static int rsp__culling         = 0;
+
+// NOTE: Kept as separate arrays so UpdateAnimations only streams through the
+// ones it touches. Stopped slots have no rate and go on the free list
+static struct {
+    float* position; // Frames into the cycle
+    float* rate;     // Frames per second, speed included
+    float* period;   // Frames in one cycle, FLT_MAX for ones that don't wrap
+    float* lower;    // Where position stops, 0 & the frame count for once
+    float* upper;
+
+    int* sprites;
+    uint8_t* loops;
+
+    int* free;
+    int free_count;
+
+    int count;
+    int capacity;
+} rsp__animations = {0};
+
+typedef struct rsp__watch {
+    SpriteBundle* bundle; // NULL for unused watches
+    char* filename;
+    const char* name; // Past the directory in filename
+
+    int descriptor; // inotify watch on the directory, -1 when polling
+    long modified;
+    int length;
+    double checked;
+
+    int changed;
+    int reloading;
+    SpriteBundle reload;
+} rsp__watch;
+
+static rsp__watch rsp__watches[RSP_MAX_BUNDLES] = {0};
+static int rsp__watch_events                    = -1; // inotify instance
+
+// NOTE: Where a deferred page is in its file, v1 pages only have the offset
+typedef struct rsp__deferred_page {
+    SpriteBundlePage location;
+    uint64_t last_used; // rsp__residency.clock when it was last drawn
+    int failed;         // Not tried again once it fails to decode or upload
+} rsp__deferred_page;
+
+typedef struct rsp__deferred {
+    char* filename;
+    uint16_t version;
+
+    rsp__deferred_page* pages;
+    size_t pages_count;
+    Texture2D* textures; // The bundle's pages, set once it has finished loading
+    Vector2* sizes;      // And their sizes, v1 pages only get one once decoded
+
+    struct rsp__deferred* next;
+} rsp__deferred;
+
+static struct {
+    size_t budget;
+    size_t used; // Every uploaded page, deferred or not
+
+    uint64_t clock;   // Counts page uses
+    uint64_t drawing; // Clock when the batch being built started, 0 between batches
+
+    rsp__deferred* deferred; // Finished deferred bundles
+} rsp__residency = {0};
 
 // Taken from https://benhoyt.com/writings/hash-table-in-c/
 static uint64_t rsp__hash (const char* key) {
@@ -82,212 +406,2480 @@ static uint64_t rsp__hash (const char* key) {
     return hash;
 }
 
+// Layout checks, a mismatch here breaks every v2 bundle
+typedef char rsp__check_sprite_size[(sizeof (Sprite) == 96) ? 1 : -1];
+typedef char rsp__check_header_size[(sizeof (SpriteBundleHeader) == 24) ? 1 : -1];
+typedef char rsp__check_section_size[(sizeof (SpriteBundleSection) == 24) ? 1 : -1];
+typedef char rsp__check_page_size[(sizeof (SpriteBundlePage) == 32) ? 1 : -1];
+
 // -----------------------------------------------------------------------------
-// USER METHODS
+// SOURCES
+//
+// Bundles are read either from a file or from memory handed to
+// LoadBundleFromMemory, memory sources are read in place wherever possible
 // -----------------------------------------------------------------------------
-int GetSpriteId (const char* name) {
-    if (rsp__current_bundle == NULL)
-        return -1;
+typedef struct rsp__source {
+    FILE* file; // NULL when reading from memory
+    const unsigned char* memory;
+    uint64_t size;
+    uint64_t position; // Only kept for memory
+} rsp__source;
+
+// Same as fread, returns how many whole items were read
+static size_t rsp__read (void* dst, size_t size, size_t count, rsp__source* source) {
+    if (source->file != NULL) {
+        count = fread (dst, size, count, source->file);
+        source->position += size * count;
+
+        return count;
+    }
 
-    uint64_t hash = rsp__hash (name);
+    const uint64_t available = (source->size - source->position) / size;
+    if (count > available)
+        count = (size_t)available;
 
-    for (size_t i = 0; i < rsp__current_bundle->sprites_count; i++) {
-        if (hash == rsp__current_bundle->sprites[i].hash)
-            return i;
-    }
+    memcpy (dst, source->memory + source->position, size * count);
+    source->position += size * count;
 
-    return -1;
+    return count;
 }
 
-void DrawSprite (int id, Vector2 position, Color colour) {
-    if (rsp__current_bundle == NULL || id > rsp__current_bundle->sprites_count)
-        return;
-    Sprite* sprite = &rsp__current_bundle->sprites[id];
+// NOTE: The file is left for the caller to close
+static FILE* rsp__open_source (const char* filename, rsp__source* source) {
+    FILE* file = fopen (filename, "rb");
+    if (file == NULL)
+        return NULL;
+
+    *source = CLITERAL (rsp__source){.file = file};
 
-    DrawTexturePro (rsp__current_bundle->atlas, sprite->source, CLITERAL (Rectangle){position.x, position.y, sprite->source.width, sprite->source.height}, sprite->origin, 0.0f, colour);
+    fseek (file, 0, SEEK_END);
+    source->size = (uint64_t)ftell (file);
+    fseek (file, 0, SEEK_SET);
+
+    return file;
 }
 
-void DrawSpriteEx (int id, Vector2 position, Vector2 scale, float rotation, Color colour) {
-    if (rsp__current_bundle == NULL || id > rsp__current_bundle->sprites_count)
-        return;
-    Sprite* sprite = &rsp__current_bundle->sprites[id];
+static int rsp__seek (rsp__source* source, uint64_t offset) {
+    if (offset > source->size)
+        return 0;
 
-    Rectangle output = CLITERAL (Rectangle){
-        .x      = position.x,
-        .y      = position.y,
-        .width  = sprite->source.width * scale.x,
-        .height = sprite->source.height * scale.y};
+    if (source->file != NULL && fseek (source->file, (long)offset, SEEK_SET) != 0)
+        return 0;
 
-    Vector2 adjusted_origin = CLITERAL (Vector2){
-        sprite->origin.x * scale.x,
-        sprite->origin.y * scale.y};
+    source->position = offset;
 
-    DrawTexturePro (rsp__current_bundle->atlas, sprite->source, output, adjusted_origin, rotation, colour);
+    return 1;
 }
 
-Vector2 GetSpriteOrigin (int id) {
-    if (rsp__current_bundle == NULL || id > rsp__current_bundle->sprites_count)
-        return CLITERAL (Vector2){0, 0};
-    ;
-    Sprite* sprite = &rsp__current_bundle->sprites[id];
+static Image rsp__decode_page (rsp__source* bundle_info) {
+    int atlas_data_size_raw = 0, atlas_data_size_compressed = 0;
 
-    return sprite->origin;
+    // NOTE: Truncated or half written files, which a hot reload can easily
+    // catch, would otherwise ask for whatever size the garbage says
+    if (rsp__read (&atlas_data_size_compressed, sizeof (int32_t), 1, bundle_info) != 1 || atlas_data_size_compressed <= 0
+        || (uint64_t)atlas_data_size_compressed > bundle_info->size - bundle_info->position)
+        return CLITERAL (Image){0};
+
+    unsigned char* atlas_data_compressed = RL_CALLOC (atlas_data_size_compressed, sizeof (unsigned char));
+    unsigned char* atlas_data_raw;
+
+    rsp__read (atlas_data_compressed, sizeof (unsigned char), atlas_data_size_compressed, bundle_info);
+    atlas_data_raw = DecompressData (atlas_data_compressed, atlas_data_size_compressed, &atlas_data_size_raw);
+
+    // NOTE: Each buffer is freed as soon as the next step is done with it, so
+    // they are never all alive at once
+    RL_FREE (atlas_data_compressed);
+
+    Image atlas_image = LoadImageFromMemory (".png", atlas_data_raw, atlas_data_size_raw);
+    RL_FREE (atlas_data_raw);
+
+    return atlas_image;
 }
 
-void SetSpriteOrigin (int id, Vector2 origin) {
-    if (rsp__current_bundle == NULL || id > rsp__current_bundle->sprites_count)
+// -----------------------------------------------------------------------------
+// RESIDENCY
+//
+// Every page upload is counted against the budget, only pages of deferred
+// bundles are ever unloaded to make room since they can be loaded again
+// -----------------------------------------------------------------------------
+static size_t rsp__page_bytes (Texture2D page) {
+    return page.id > 0 ? (size_t)GetPixelDataSize (page.width, page.height, page.format) : 0;
+}
+
+static void rsp__unload_page (Texture2D* page) {
+    if (page->id == 0)
         return;
-    Sprite* sprite = &rsp__current_bundle->sprites[id];
 
-    sprite->origin = origin;
+    rsp__residency.used -= rsp__page_bytes (*page);
+
+    if (rsp__page_callbacks.unload != NULL)
+        rsp__page_callbacks.unload (*page);
+    else
+        UnloadTexture (*page);
+
+    *page = CLITERAL (Texture2D){0};
 }
 
-Vector2 GetSpriteSize (int id) {
-    if (rsp__current_bundle == NULL || id > rsp__current_bundle->sprites_count)
-        return CLITERAL (Vector2){0, 0};
-    Sprite* sprite = &rsp__current_bundle->sprites[id];
+// NOTE: Unloads the deferred pages drawn longest ago until bytes more fits.
+// Whatever rlgl still has queued is drawn first, as it may use them
+static void rsp__make_room (size_t bytes) {
+    int flushed = 0;
+
+    while (rsp__residency.budget > 0 && rsp__residency.used + bytes > rsp__residency.budget) {
+        rsp__deferred* oldest = NULL;
+        size_t oldest_page    = 0;
+
+        for (rsp__deferred* deferred = rsp__residency.deferred; deferred != NULL; deferred = deferred->next) {
+            for (size_t i = 0; i < deferred->pages_count; i++) {
+                const uint64_t last_used = deferred->pages[i].last_used;
+
+                // NOTE: Quads of the batch being built are already pointing at
+                // their pages, those only go once it has been submitted
+                if (deferred->textures[i].id == 0 || (rsp__residency.drawing > 0 && last_used >= rsp__residency.drawing))
+                    continue;
+
+                if (oldest == NULL || last_used < oldest->pages[oldest_page].last_used) {
+                    oldest      = deferred;
+                    oldest_page = i;
+                }
+            }
+        }
+
+        if (oldest == NULL)
+            break;
+
+        // NOTE: There is no batch to draw without a window, as with the mock
+        // uploads in tests
+        if (!flushed) {
+            if (IsWindowReady ())
+                rlDrawRenderBatchActive ();
+
+            flushed = 1;
+        }
 
-    return CLITERAL (Vector2){sprite->source.width, sprite->source.height};
+        rsp__unload_page (&oldest->textures[oldest_page]);
+    }
 }
 
-const char* GetSpriteName (int id) {
-    if (rsp__current_bundle == NULL || id > rsp__current_bundle->sprites_count)
-        return "null";
-    Sprite* sprite = &rsp__current_bundle->sprites[id];
+// Uploads and frees a decoded page, a page that failed to decode stays empty
+static Texture2D rsp__upload_page (Image image) {
+    Texture2D page = CLITERAL (Texture2D){0};
 
-    return sprite->name;
+    if (image.data != NULL) {
+        rsp__make_room ((size_t)GetPixelDataSize (image.width, image.height, image.format));
+
+        page = rsp__page_callbacks.upload != NULL ? rsp__page_callbacks.upload (image) : LoadTextureFromImage (image);
+        UnloadImage (image);
+
+        rsp__residency.used += rsp__page_bytes (page);
+    }
+
+    return page;
+}
+
+// Gets each page as soon as it is decoded, in order and including the ones
+// that failed. The sink owns the image from then on.
+typedef void (*rsp__page_sink) (SpriteBundle* bundle, size_t index, Image image, void* user);
+
+static void rsp__upload_sink (SpriteBundle* bundle, size_t index, Image image, void* user) {
+    (void)user;
+
+    bundle->pages[index] = rsp__upload_page (image);
 }
 
 // -----------------------------------------------------------------------------
-// CORE METHODS
+// PAGE STREAMING
+//
+// v2 payloads are read a chunk at a time straight from the file, only the
+// final pixel buffer is ever the size of a page
 // -----------------------------------------------------------------------------
-SpriteBundle LoadBundle (const char* filename) {
-    SpriteBundle bundle = {0};
+#define RSP_STREAM_CHUNK_SIZE (64 * 1024)
 
-    FILE* bundle_info = fopen (filename, "rb");
-    if (!bundle_info) {
-        TraceLog (LOG_ERROR, "BUNDLE: [%s] Failed to open file", filename);
-        goto bundle_close;
+typedef struct rsp__stream {
+    rsp__source* source;
+    uint64_t remaining; // Payload bytes not read into the chunk yet
+
+    const unsigned char* chunk; // Either buffer or straight into memory sources
+    size_t position;
+    size_t size;
+
+    unsigned char buffer[RSP_STREAM_CHUNK_SIZE];
+} rsp__stream;
+
+static int rsp__stream_fill (rsp__stream* stream) {
+    if (stream->remaining == 0)
+        return 0;
+
+    rsp__source* source = stream->source;
+    stream->position    = 0;
+
+    // NOTE: Memory is handed out as a single chunk, nothing is copied
+    if (source->file == NULL) {
+        stream->chunk = source->memory + source->position;
+        stream->size  = (size_t)stream->remaining;
+
+        source->position += stream->remaining;
+        stream->remaining = 0;
+
+        return 1;
     }
 
-    char* file_type = RL_MALLOC (sizeof (char) * 4);
-    fread (file_type, sizeof (char), 4, bundle_info);
+    size_t size = stream->remaining < RSP_STREAM_CHUNK_SIZE ? (size_t)stream->remaining : RSP_STREAM_CHUNK_SIZE;
 
-    if (!TextIsEqual (file_type, "RSPX")) {
-        TraceLog (LOG_ERROR, "BUNDLE: [%s] File was not a sprite bundle", file_type);
-        goto bundle_close;
+    stream->chunk = stream->buffer;
+    stream->size  = fread (stream->buffer, 1, size, source->file);
+    stream->remaining -= size;
+
+    return stream->size == size;
+}
+
+static int rsp__stream_end (const rsp__stream* stream) {
+    return stream->position == stream->size && stream->remaining == 0;
+}
+
+static int rsp__stream_byte (rsp__stream* stream, unsigned char* byte) {
+    if (stream->position == stream->size && !rsp__stream_fill (stream))
+        return 0;
+
+    *byte = stream->chunk[stream->position++];
+
+    return 1;
+}
+
+// NOTE: Whatever is already in the chunk goes first, anything past it is read
+// straight into dst without going through the chunk at all
+static int rsp__stream_read (rsp__stream* stream, unsigned char* dst, size_t size) {
+    size_t buffered = stream->size - stream->position;
+    if (buffered > size)
+        buffered = size;
+
+    if (buffered > 0)
+        memcpy (dst, stream->chunk + stream->position, buffered);
+
+    stream->position += buffered;
+
+    size -= buffered;
+    if (size == 0)
+        return 1;
+
+    if (size > stream->remaining)
+        return 0;
+
+    // NOTE: Memory sources only ever get here before the first fill
+    if (stream->source->file == NULL)
+        return rsp__stream_fill (stream) && rsp__stream_read (stream, dst + buffered, size);
+
+    stream->remaining -= size;
+
+    return fread (dst + buffered, 1, size, stream->source->file) == size;
+}
+
+// LZ4 lengths past 15 carry on in bytes until one isn't 255
+static int rsp__stream_length (rsp__stream* stream, size_t* length) {
+    unsigned char extra = 255;
+
+    while (extra == 255) {
+        if (!rsp__stream_byte (stream, &extra))
+            return 0;
+
+        *length += extra;
     }
 
-    int atlas_data_size_raw, atlas_data_size_compressed;
+    return 1;
+}
 
-    fread (&bundle.sprites_count, sizeof (uint16_t), 1, bundle_info);
-    fread (&atlas_data_size_compressed, sizeof (int32_t), 1, bundle_info);
+// NOTE: Every length is checked against the output, a corrupt payload fails
+// instead of writing outside it. Only succeeds when dst is filled exactly.
+static int rsp__decode_lz4 (rsp__stream* stream, unsigned char* dst, size_t dst_size) {
+    unsigned char* out     = dst;
+    unsigned char* out_end = dst + dst_size;
 
-    unsigned char* atlas_data_compressed = RL_CALLOC (atlas_data_size_compressed, sizeof (unsigned char));
-    unsigned char* atlas_data_raw;
+    while (!rsp__stream_end (stream)) {
+        unsigned char token;
+        if (!rsp__stream_byte (stream, &token))
+            return 0;
 
-    fread (atlas_data_compressed, sizeof (unsigned char), atlas_data_size_compressed, bundle_info);
-    atlas_data_raw = DecompressData (atlas_data_compressed, atlas_data_size_compressed, &atlas_data_size_raw);
+        size_t length = token >> 4;
 
-    Image atlas_image = LoadImageFromMemory (".png", atlas_data_raw, atlas_data_size_raw);
-    bundle.atlas      = LoadTextureFromImage (atlas_image);
+        if (length == 15 && !rsp__stream_length (stream, &length))
+            return 0;
 
-    UnloadImage (atlas_image);
+        if (length > (size_t)(out_end - out) || !rsp__stream_read (stream, out, length))
+            return 0;
 
-    RL_FREE (atlas_data_compressed);
-    RL_FREE (atlas_data_raw);
+        out += length;
 
-    bundle.sprites = RL_CALLOC (bundle.sprites_count, sizeof (Sprite));
-    char* header   = RL_CALLOC (HEADER_SIZE, sizeof (unsigned char));
+        // NOTE: The last sequence is literals only
+        if (rsp__stream_end (stream))
+            break;
 
-    for (size_t i = 0; i < bundle.sprites_count; i++) {
-        fread (header, sizeof (char), HEADER_SIZE, bundle_info);
+        unsigned char offset_bytes[2];
+        if (!rsp__stream_read (stream, offset_bytes, 2))
+            return 0;
 
-        if (!TextIsEqual ("SPR", header)) {
-            TraceLog (LOG_ERROR, "BUNDLE: [%s] Expected [RSP] header", header);
-            bundle.sprites_count = i;
+        const size_t offset = (size_t)offset_bytes[0] | (size_t)offset_bytes[1] << 8;
 
-            UnloadBundle (bundle);
+        if (offset == 0 || offset > (size_t)(out - dst))
+            return 0;
 
-            goto bundle_free;
-        }
+        length = token & 15;
 
-        Sprite* sprite = &bundle.sprites[i];
+        if (length == 15 && !rsp__stream_length (stream, &length))
+            return 0;
 
-        fread (sprite->name, sizeof (char), MAX_SPRITE_NAME_LENGTH, bundle_info);
-        fread (&sprite->flags, sizeof (uint16_t), 1, bundle_info);
+        length += 4;
 
-        sprite->hash = rsp__hash (sprite->name);
+        if (length > (size_t)(out_end - out))
+            return 0;
 
-        // Origin
-        fread (&sprite->origin.x, sizeof (float), 1, bundle_info);
-        fread (&sprite->origin.y, sizeof (float), 1, bundle_info);
+        // NOTE: Overlapping matches repeat the last offset bytes, copying what
+        // is already written doubles the run each time instead of going a byte
+        // at a time, transparent areas are mostly offset 1 or 4 runs
+        if (offset >= length)
+            memcpy (out, out - offset, length);
+        else {
+            memcpy (out, out - offset, offset);
 
-        // Source
-        fread (&sprite->source.x, sizeof (float), 1, bundle_info);
-        fread (&sprite->source.y, sizeof (float), 1, bundle_info);
-        fread (&sprite->source.width, sizeof (float), 1, bundle_info);
-        fread (&sprite->source.height, sizeof (float), 1, bundle_info);
+            for (size_t copied = offset; copied < length;) {
+                size_t chunk = copied < length - copied ? copied : length - copied;
 
-        if (sprite->flags & RSP_SPRITE_ANIMATED) {
-            fread (&sprite->animation.frames_count, sizeof (uint16_t), 1, bundle_info);
-            sprite->animation.frames = RL_CALLOC (sprite->animation.frames_count, sizeof (Rectangle));
-
-            for (size_t j = 0; j < sprite->animation.frames_count; j++) {
-                fread (&sprite->animation.frames[j].x, sizeof (float), 1, bundle_info);
-                fread (&sprite->animation.frames[j].y, sizeof (float), 1, bundle_info);
-                fread (&sprite->animation.frames[j].width, sizeof (float), 1, bundle_info);
-                fread (&sprite->animation.frames[j].height, sizeof (float), 1, bundle_info);
+                memcpy (out + copied, out, chunk);
+                copied += chunk;
             }
         }
+
+        out += length;
     }
 
-bundle_free:
-    RL_FREE (header);
+    return out == out_end;
+}
+
+static int rsp__qoi_hash (const unsigned char* pixel) {
+    return (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+}
 
-bundle_close:
-    fclose (bundle_info);
+// NOTE: Always decodes to 4 channels, the image has to be exactly the size the
+// page table says. The end marker is never read, running out of ops early
+// fails either way.
+static int rsp__decode_qoi (rsp__stream* stream, unsigned char* dst, uint32_t width, uint32_t height) {
+    unsigned char header[14];
+
+    if (!rsp__stream_read (stream, header, sizeof (header)) || memcmp (header, "qoif", 4) != 0)
+        return 0;
+
+    const uint32_t image_width  = (uint32_t)header[4] << 24 | (uint32_t)header[5] << 16 | (uint32_t)header[6] << 8 | header[7];
+    const uint32_t image_height = (uint32_t)header[8] << 24 | (uint32_t)header[9] << 16 | (uint32_t)header[10] << 8 | header[11];
+
+    if (image_width != width || image_height != height)
+        return 0;
+
+    unsigned char index[64][4] = {{0}};
+    unsigned char pixel[4]     = {0, 0, 0, 255};
+
+    const size_t count = (size_t)width * height;
+    int run            = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (run > 0)
+            run--;
+        else {
+            unsigned char op;
+            if (!rsp__stream_byte (stream, &op))
+                return 0;
+
+            if (op == 0xFE || op == 0xFF) {
+                if (!rsp__stream_read (stream, pixel, op == 0xFE ? 3 : 4))
+                    return 0;
+            } else if ((op & 0xC0) == 0x00)
+                memcpy (pixel, index[op], 4);
+            else if ((op & 0xC0) == 0x40) {
+                pixel[0] += ((op >> 4) & 0x03) - 2;
+                pixel[1] += ((op >> 2) & 0x03) - 2;
+                pixel[2] += (op & 0x03) - 2;
+            } else if ((op & 0xC0) == 0x80) {
+                unsigned char next;
+                if (!rsp__stream_byte (stream, &next))
+                    return 0;
+
+                const int dg = (op & 0x3F) - 32;
+
+                pixel[0] += dg - 8 + ((next >> 4) & 0x0F);
+                pixel[1] += dg;
+                pixel[2] += dg - 8 + (next & 0x0F);
+            } else
+                run = op & 0x3F;
+
+            memcpy (index[rsp__qoi_hash (pixel)], pixel, 4);
+        }
 
-    bundle.id = ++rsp__bundles_loaded;
+        memcpy (dst + i * 4, pixel, 4);
+    }
 
-    return bundle;
+    return 1;
 }
 
-void SetActiveBundle (SpriteBundle* bundle) {
-    rsp__current_bundle = bundle;
+// NOTE: Decodes into the buffer handed to the upload, PNG is the only codec
+// that needs its whole payload in memory first
+static Image rsp__decode_page_v2 (rsp__source* source, const SpriteBundlePage* page) {
+    Image image = CLITERAL (Image){0};
+
+    if (page->size > INT32_MAX || !rsp__seek (source, page->offset))
+        return image;
+
+    if (page->codec == BUNDLE_CODEC_PNG) {
+        if (source->file == NULL)
+            return LoadImageFromMemory (".png", source->memory + page->offset, (int)page->size);
+
+        unsigned char* data = RL_MALLOC ((size_t)page->size);
+        if (data == NULL)
+            return image;
+
+        // NOTE: Freed before the upload so the PNG, the image & the texture are
+        // never all alive at once
+        if (rsp__read (data, 1, (size_t)page->size, source) == page->size)
+            image = LoadImageFromMemory (".png", data, (int)page->size);
+
+        RL_FREE (data);
+
+        return image;
+    }
+
+    if (page->width == 0 || page->height == 0 || page->width > 16384 || page->height > 16384)
+        return image;
+
+    const size_t pixels_size = (size_t)page->width * page->height * 4;
+
+    image = CLITERAL (Image){
+        .data    = RL_MALLOC (pixels_size),
+        .width   = (int)page->width,
+        .height  = (int)page->height,
+        .mipmaps = 1,
+        .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+
+    // NOTE: The chunk is too big to comfortably keep on the stack
+    rsp__stream* stream = RL_MALLOC (sizeof (rsp__stream));
+    int decoded         = 0;
+
+    if (image.data != NULL && stream != NULL) {
+        *stream = CLITERAL (rsp__stream){.source = source, .remaining = page->size};
+
+        if (page->codec == BUNDLE_CODEC_LZ4)
+            decoded = rsp__decode_lz4 (stream, (unsigned char*)image.data, pixels_size);
+        else if (page->codec == BUNDLE_CODEC_QOI)
+            decoded = rsp__decode_qoi (stream, (unsigned char*)image.data, page->width, page->height);
+        else if (page->codec == BUNDLE_CODEC_RAW)
+            decoded = page->size == pixels_size && rsp__stream_read (stream, (unsigned char*)image.data, pixels_size);
+    }
+
+    RL_FREE (stream);
+
+    if (!decoded) {
+        RL_FREE (image.data);
+        image = CLITERAL (Image){0};
+    }
+
+    return image;
 }
 
-int IsBundleReady (SpriteBundle bundle) {
-    int result = 0;
+// -----------------------------------------------------------------------------
+// DEFERRED PAGES
+//
+// Deferred bundles are read with no page sink, each page is skipped over with
+// only where it is kept, then decoded from there the first time it is drawn
+// -----------------------------------------------------------------------------
+static void rsp__defer_page (SpriteBundle* bundle, size_t index, const SpriteBundlePage* location, int failed) {
+    rsp__deferred* deferred = (rsp__deferred*)bundle->deferred;
 
-    if ((bundle.sprites_count != 0) && (IsTextureReady (bundle.atlas)))
-        result = 1;
+    if (index >= deferred->pages_count) {
+        rsp__deferred_page* pages = RL_REALLOC (deferred->pages, (index + 1) * sizeof (rsp__deferred_page));
+        if (pages == NULL)
+            return;
 
-    return result;
+        memset (pages + deferred->pages_count, 0, (index + 1 - deferred->pages_count) * sizeof (rsp__deferred_page));
+
+        deferred->pages       = pages;
+        deferred->pages_count = index + 1;
+    }
+
+    deferred->pages[index] = CLITERAL (rsp__deferred_page){.location = *location, .failed = failed};
 }
 
-void UnloadBundle (SpriteBundle bundle) {
-    for (size_t i = 0; i < bundle.sprites_count; i++) {
-        Sprite* sprite = &bundle.sprites[i];
+// NOTE: v1 pages are a size followed by the payload, so deferred ones are
+// stepped over without reading the payload at all
+static void rsp__read_page_v1 (SpriteBundle* bundle, size_t index, rsp__source* source, rsp__page_sink sink, void* user) {
+    if (sink != NULL) {
+        const Image image = rsp__decode_page (source);
 
-        if (sprite->flags & RSP_SPRITE_ANIMATED) {
-            RL_FREE (sprite->animation.frames);
+        bundle->page_sizes[index] = CLITERAL (Vector2){(float)image.width, (float)image.height};
+        sink (bundle, index, image, user);
+
+        return;
+    }
+
+    const SpriteBundlePage location = CLITERAL (SpriteBundlePage){.offset = source->position};
+    int32_t size                    = 0;
+    int failed                      = 1;
+
+    if (rsp__read (&size, sizeof (int32_t), 1, source) == 1 && size > 0 && (uint64_t)size <= source->size - source->position)
+        failed = !rsp__seek (source, source->position + (uint64_t)size);
+
+    rsp__defer_page (bundle, index, &location, failed);
+}
+
+static void rsp__load_deferred_page (rsp__deferred* deferred, size_t index) {
+    rsp__deferred_page* page = &deferred->pages[index];
+    rsp__source source       = CLITERAL (rsp__source){0};
+    Image image              = CLITERAL (Image){0};
+
+    FILE* file = rsp__open_source (deferred->filename, &source);
+
+    if (file != NULL) {
+        if (deferred->version >= 2)
+            image = rsp__decode_page_v2 (&source, &page->location);
+        else if (rsp__seek (&source, page->location.offset))
+            image = rsp__decode_page (&source);
+
+        fclose (file);
+    }
+
+    if (image.data != NULL) {
+        deferred->sizes[index]    = CLITERAL (Vector2){(float)image.width, (float)image.height};
+        deferred->textures[index] = rsp__upload_page (image);
+    }
+
+    if (deferred->textures[index].id == 0) {
+        TraceLog (LOG_WARNING, "BUNDLE: [%s] Page %zu failed to load", deferred->filename, index);
+        page->failed = 1;
+    }
+}
+
+static void rsp__build_quads (const SpriteBundle* bundle);
+
+// NOTE: Texture of a page about to be drawn, loading it first if it is
+// deferred. 0 when there is nothing to draw it with
+static unsigned int rsp__use_page (const SpriteBundle* bundle, uint16_t page) {
+    if (page >= bundle->pages_count)
+        return 0;
+
+    rsp__deferred* deferred = (rsp__deferred*)bundle->deferred;
+
+    if (deferred != NULL) {
+        deferred->pages[page].last_used = ++rsp__residency.clock;
+
+        if (bundle->pages[page].id == 0 && !deferred->pages[page].failed) {
+            const int sized = bundle->page_sizes[page].x > 0.0f;
+
+            rsp__load_deferred_page (deferred, page);
+
+            // NOTE: Only v1 pages turn up without a size, their sprites get
+            // texture coordinates now that there is one
+            if (!sized && bundle->page_sizes[page].x > 0.0f)
+                rsp__build_quads (bundle);
         }
     }
 
-    RL_FREE (bundle.sprites);
+    return bundle->pages[page].id;
+}
 
-    UnloadTexture (bundle.atlas);
+// Whether the page can be drawn without loading it to find out
+static int rsp__has_page (const SpriteBundle* bundle, uint16_t page) {
+    const rsp__deferred* deferred = (const rsp__deferred*)bundle->deferred;
 
-    TraceLog (LOG_INFO, "BUNDLE: [ID %d] Sprite bundle unloaded successfully", bundle.id);
+    return page < bundle->pages_count && (bundle->pages[page].id != 0 || (deferred != NULL && !deferred->pages[page].failed));
+}
+
+// NOTE: Only once the bundle is finished, v1 bundles only know how many pages
+// they have by the end. Pages that never turned up are left failed
+static int rsp__finish_deferred (SpriteBundle* bundle) {
+    rsp__deferred* deferred        = (rsp__deferred*)bundle->deferred;
+    const SpriteBundlePage missing = CLITERAL (SpriteBundlePage){0};
+
+    for (size_t i = deferred->pages_count; i < bundle->pages_count; i++)
+        rsp__defer_page (bundle, i, &missing, 1);
+
+    if (deferred->pages_count < bundle->pages_count)
+        return 0;
+
+    deferred->textures = bundle->pages;
+    deferred->sizes    = bundle->page_sizes;
+    deferred->next     = rsp__residency.deferred;
+
+    rsp__residency.deferred = deferred;
+
+    return 1;
+}
+
+static void rsp__free_deferred (rsp__deferred* deferred) {
+    for (rsp__deferred** link = &rsp__residency.deferred; *link != NULL; link = &(*link)->next) {
+        if (*link == deferred) {
+            *link = deferred->next;
+            break;
+        }
+    }
+
+    RL_FREE (deferred->pages);
+    RL_FREE (deferred->filename);
+    RL_FREE (deferred);
+}
+
+static int rsp__is_little_endian (void) {
+    const uint16_t value = 1;
+
+    return *(const uint8_t*)&value == 1;
+}
+
+// NOTE: Only the front of the file holding the tables is mapped, privately so
+// SetSpriteOrigin can write to the sprite table without touching the file.
+// Windows just reads it in. Watched bundles copy it out, see rsp__detach_tables
+static void* rsp__map_file (FILE* file, size_t size, int* mapped) {
+    *mapped = 0;
+
+#if defined(_WIN32)
+    unsigned char* data = RL_MALLOC (size);
+
+    if (data != NULL && (fseek (file, 0, SEEK_SET) != 0 || fread (data, 1, size, file) != size)) {
+        RL_FREE (data);
+        data = NULL;
+    }
+
+    return data;
+#else
+    void* data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (file), 0);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    *mapped = 1;
+
+    return data;
+#endif
+}
+
+static void rsp__unmap_file (void* data, size_t size, int mapped) {
+#if !defined(_WIN32)
+    if (mapped) {
+        munmap (data, size);
+        return;
+    }
+#endif
+
+    RL_FREE (data);
+}
+
+// NOTE: Sprites read in place from memory are the caller's, they get copied
+// the first time something needs to write to them
+static int rsp__own_sprites (SpriteBundle* bundle) {
+    if (!bundle->in_place || bundle->sprites_owned)
+        return 1;
+
+    Sprite* sprites = RL_MALLOC (bundle->sprites_count * sizeof (Sprite));
+    if (sprites == NULL)
+        return 0;
+
+    memcpy (sprites, bundle->sprites, bundle->sprites_count * sizeof (Sprite));
+
+    bundle->sprites       = sprites;
+    bundle->sprites_owned = 1;
+
+    return 1;
+}
+
+// NOTE: Kept at most half full so every probe ends on an empty slot
+static void rsp__build_index (SpriteBundle* bundle) {
+    const uint32_t bits = bundle->index_bits;
+    const uint32_t mask = ((uint32_t)1 << bits) - 1;
+
+    for (uint32_t i = 0; i < bundle->sprites_count; i++) {
+        const uint64_t hash = bundle->sprites[i].hash;
+        uint32_t slot       = (uint32_t)((hash * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+
+        // NOTE: Duplicate names keep the first sprite, like the old linear scan
+        for (; bundle->index[slot] != 0; slot = (slot + 1) & mask) {
+            if (bundle->sprites[(bundle->index[slot] & 0xFFFFFFFF) - 1].hash == hash)
+                break;
+        }
+
+        if (bundle->index[slot] == 0)
+            bundle->index[slot] = (hash & 0xFFFFFFFF00000000ULL) | (i + 1);
+    }
+}
+
+// NOTE: A matching top half is confirmed against the sprite itself, the
+// only time a lookup reads outside the index
+static int rsp__find_sprite (const SpriteBundle* bundle, uint64_t hash) {
+    if (bundle->index == NULL) {
+        for (size_t i = 0; i < bundle->sprites_count; i++) {
+            if (hash == bundle->sprites[i].hash)
+                return i;
+        }
+
+        return -1;
+    }
+
+    const uint32_t mask = ((uint32_t)1 << bundle->index_bits) - 1;
+    uint32_t slot       = (uint32_t)((hash * 0x9E3779B97F4A7C15ULL) >> (64 - bundle->index_bits));
+
+    for (uint64_t entry = bundle->index[slot]; entry != 0; entry = bundle->index[slot = (slot + 1) & mask]) {
+        const int id = (int)(entry & 0xFFFFFFFF) - 1;
+
+        if ((entry >> 32) == (hash >> 32) && bundle->sprites[id].hash == hash)
+            return id;
+    }
+
+    return -1;
+}
+
+// NOTE: Sizes come from the bundle rather than the uploaded textures, so the
+// coordinates are there before any page is
+static void rsp__build_quads (const SpriteBundle* bundle) {
+    for (size_t i = 0; i < bundle->sprites_count; i++) {
+        const Sprite* sprite = &bundle->sprites[i];
+        SpriteQuad* quad     = &bundle->quads[i];
+
+        // NOTE: Pages with no size yet, v1 pages that are deferred or failed
+        // to decode, leave the coordinates empty
+        const Vector2 size = sprite->page < bundle->pages_count ? bundle->page_sizes[sprite->page] : CLITERAL (Vector2){0};
+        const float width  = size.x;
+        const float height = size.y;
+
+        *quad = CLITERAL (SpriteQuad){
+            .size   = CLITERAL (Vector2){sprite->source.width, sprite->source.height},
+            .origin = CLITERAL (Vector2){sprite->origin.x - sprite->offset.x, sprite->origin.y - sprite->offset.y},
+            .page   = sprite->page,
+            .flags  = sprite->flags};
+
+        if (width > 0.0f && height > 0.0f) {
+            quad->uv_min = CLITERAL (Vector2){sprite->source.x / width, sprite->source.y / height};
+            quad->uv_max = CLITERAL (Vector2){(sprite->source.x + sprite->source.width) / width, (sprite->source.y + sprite->source.height) / height};
+        }
+    }
+}
+
+#define RSP_ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+// NOTE: Carves pages, quads & the index out of one allocation. Whatever was
+// already allocated on its own (v1 pages & sizes, sprites & frames) is moved in and
+// freed, so the bundle ends up holding just this and its data
+static int rsp__alloc_arena (SpriteBundle* bundle) {
+    uint32_t bits = 4;
+    while (((uint32_t)1 << bits) < (uint32_t)bundle->sprites_count * 2)
+        bits++;
+
+    const size_t pages_size   = RSP_ARENA_ALIGN (bundle->pages_count * sizeof (Texture2D));
+    const size_t sizes_size   = RSP_ARENA_ALIGN (bundle->pages_count * sizeof (Vector2));
+    const size_t quads_size   = RSP_ARENA_ALIGN (bundle->sprites_count * sizeof (SpriteQuad));
+    const size_t index_size   = ((size_t)1 << bits) * sizeof (uint64_t);
+    const size_t sprites_size = bundle->sprites_owned ? bundle->sprites_count * sizeof (Sprite) : 0;
+    const size_t frames_size  = bundle->frames_owned ? bundle->frames_count * sizeof (Rectangle) : 0;
+
+    unsigned char* arena = RL_CALLOC (1, pages_size + sizes_size + quads_size + index_size + sprites_size + frames_size);
+    if (arena == NULL)
+        return 0;
+
+    unsigned char* next = arena;
+
+    if (bundle->pages != NULL) {
+        memcpy (next, bundle->pages, bundle->pages_count * sizeof (Texture2D));
+        RL_FREE (bundle->pages);
+    }
+
+    bundle->pages = (Texture2D*)next;
+    next += pages_size;
+
+    if (bundle->page_sizes != NULL) {
+        memcpy (next, bundle->page_sizes, bundle->pages_count * sizeof (Vector2));
+        RL_FREE (bundle->page_sizes);
+    }
+
+    bundle->page_sizes = (Vector2*)next;
+    next += sizes_size;
+
+    bundle->quads = (SpriteQuad*)next;
+    next += quads_size;
+
+    bundle->index      = (uint64_t*)next;
+    bundle->index_bits = bits;
+    next += index_size;
+
+    if (bundle->sprites_owned) {
+        memcpy (next, bundle->sprites, sprites_size);
+        RL_FREE (bundle->sprites);
+
+        bundle->sprites       = (Sprite*)next;
+        bundle->sprites_owned = 0;
+        next += sprites_size;
+    }
+
+    if (bundle->frames_owned) {
+        if (frames_size > 0)
+            memcpy (next, bundle->frames, frames_size);
+        RL_FREE (bundle->frames);
+
+        bundle->frames       = frames_size > 0 ? (Rectangle*)next : NULL;
+        bundle->frames_owned = 0;
+    }
+
+    bundle->arena = arena;
+
+    return 1;
+}
+
+#undef RSP_ARENA_ALIGN
+
+// NOTE: Everything a bundle needs once its tables & pages are in, returns 0
+// when the arena couldn't be made
+static int rsp__finish_bundle (SpriteBundle* bundle) {
+    if (bundle->arena == NULL && !rsp__alloc_arena (bundle))
+        return 0;
+
+    rsp__build_index (bundle);
+    rsp__build_quads (bundle);
+
+    bundle->id = ++rsp__bundles_loaded;
+
+    return 1;
+}
+
+static void rsp__free_bundle (SpriteBundle* bundle) {
+    if (bundle->data != NULL)
+        rsp__unmap_file (bundle->data, bundle->data_size, bundle->data_mapped);
+
+    if (bundle->sprites_owned)
+        RL_FREE (bundle->sprites);
+
+    if (bundle->frames_owned)
+        RL_FREE (bundle->frames);
+
+    for (size_t i = 0; bundle->pages != NULL && i < bundle->pages_count; i++)
+        rsp__unload_page (&bundle->pages[i]);
+
+    if (bundle->deferred != NULL)
+        rsp__free_deferred ((rsp__deferred*)bundle->deferred);
+
+    // NOTE: v1 pages are only their own allocation until the arena is made
+    if (bundle->arena != NULL)
+        RL_FREE (bundle->arena);
+    else {
+        RL_FREE (bundle->pages);
+        RL_FREE (bundle->page_sizes);
+    }
+
+    *bundle = CLITERAL (SpriteBundle){0};
+}
+
+static const SpriteBundleSection* rsp__find_section (const SpriteBundleHeader* header, const char* tag) {
+    const SpriteBundleSection* sections = (const SpriteBundleSection*)((const unsigned char*)header + header->header_size);
+
+    for (size_t i = 0; i < header->sections_count; i++) {
+        if (memcmp (sections[i].tag, tag, 4) == 0)
+            return &sections[i];
+    }
+
+    return NULL;
+}
+
+// NOTE: Only checks what is needed to use the tables in place safely, returns 0
+// when the bundle can't be used
+static int rsp__load_bundle_v2 (SpriteBundle* bundle, rsp__source* source, const char* filename, rsp__page_sink sink, void* user) {
+    if (!rsp__is_little_endian ()) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Version 2 bundles need a little endian host", filename);
+        return 0;
+    }
+
+    SpriteBundleHeader header = CLITERAL (SpriteBundleHeader){0};
+    const uint64_t file_size  = source->size;
+
+    rsp__seek (source, 0);
+    rsp__read (&header, sizeof (SpriteBundleHeader), 1, source);
+
+    if (header.version > RSP_BUNDLE_VERSION || header.header_size != sizeof (SpriteBundleHeader) || header.file_size != file_size
+        || header.header_size + (uint64_t)header.sections_count * sizeof (SpriteBundleSection) > file_size) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Invalid or unsupported version 2 header", filename);
+        return 0;
+    }
+
+    // NOTE: Tables are everything the sections point at, the page payloads
+    // after them are left in the file until they are streamed in
+    uint64_t tables_size = header.header_size + (uint64_t)header.sections_count * sizeof (SpriteBundleSection);
+
+    for (size_t i = 0; i < header.sections_count; i++) {
+        SpriteBundleSection section = CLITERAL (SpriteBundleSection){0};
+        rsp__read (&section, sizeof (SpriteBundleSection), 1, source);
+
+        // NOTE: Written so a crafted size can't wrap around past the check
+        if (section.offset % 8 != 0 || section.offset > file_size || section.size > file_size - section.offset) {
+            TraceLog (LOG_ERROR, "BUNDLE: [%s] Section [%.4s] out of bounds", filename, section.tag);
+            return 0;
+        }
+
+        if (section.offset + section.size > tables_size)
+            tables_size = section.offset + section.size;
+    }
+
+    // NOTE: Memory aligned well enough for the tables is used in place and
+    // never written to, anything else gets its own copy
+    unsigned char* data = (unsigned char*)source->memory;
+
+    if (source->file != NULL || (uintptr_t)source->memory % 8 != 0) {
+        bundle->data_size = (size_t)tables_size;
+
+        if (source->file != NULL)
+            bundle->data = rsp__map_file (source->file, bundle->data_size, &bundle->data_mapped);
+        else if ((bundle->data = RL_MALLOC (bundle->data_size)) != NULL)
+            memcpy (bundle->data, source->memory, bundle->data_size);
+
+        if (bundle->data == NULL) {
+            TraceLog (LOG_ERROR, "BUNDLE: [%s] Failed to map file", filename);
+            return 0;
+        }
+
+        data = (unsigned char*)bundle->data;
+    } else
+        bundle->in_place = 1;
+
+    const SpriteBundleSection* sprites = rsp__find_section ((const SpriteBundleHeader*)data, "SPRT");
+    const SpriteBundleSection* frames  = rsp__find_section ((const SpriteBundleHeader*)data, "FRMS");
+    const SpriteBundleSection* pages   = rsp__find_section ((const SpriteBundleHeader*)data, "PAGE");
+
+    // NOTE: Frames are optional, but a table that is there has to add up
+    if (sprites == NULL || pages == NULL || sprites->size != (uint64_t)sprites->count * sizeof (Sprite)
+        || pages->size != (uint64_t)pages->count * sizeof (SpriteBundlePage)
+        || (frames != NULL && frames->size != (uint64_t)frames->count * sizeof (Rectangle))) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Missing or malformed sections", filename);
+        return 0;
+    }
+
+    // NOTE: Sprite ids only have 16 bits for the index, anything past that
+    // would wrap around onto other sprites
+    if (sprites->count > UINT16_MAX || pages->count > UINT16_MAX) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Too many sprites or pages (%u, %u)", filename, sprites->count, pages->count);
+        return 0;
+    }
+
+    // NOTE: Baked bundles come with their sprites, the table in the file is
+    // never read, only its count is checked against them
+    if (bundle->sprites != NULL) {
+        if (sprites->count != bundle->sprites_count) {
+            TraceLog (LOG_ERROR, "BUNDLE: [%s] Baked sprites are from another export (%u in the file, %u baked)", filename, sprites->count, bundle->sprites_count);
+            return 0;
+        }
+    } else {
+        bundle->sprites       = (Sprite*)(data + sprites->offset);
+        bundle->sprites_count = (uint16_t)sprites->count;
+    }
+
+    if (frames != NULL) {
+        bundle->frames       = (Rectangle*)(data + frames->offset);
+        bundle->frames_count = frames->count;
+    }
+
+    const SpriteBundlePage* page_table = (const SpriteBundlePage*)(data + pages->offset);
+
+    bundle->pages_count = (uint16_t)pages->count;
+
+    if (!rsp__alloc_arena (bundle)) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Failed to allocate bundle", filename);
+        return 0;
+    }
+
+    // NOTE: Deferred bundles only keep where each page is for now
+    if (sink == NULL)
+        ((rsp__deferred*)bundle->deferred)->version = header.version;
+
+    for (size_t i = 0; i < bundle->pages_count; i++) {
+        const SpriteBundlePage* page = &page_table[i];
+        const int in_bounds          = page->offset <= file_size && page->size <= file_size - page->offset;
+
+        bundle->page_sizes[i] = CLITERAL (Vector2){(float)page->width, (float)page->height};
+
+        if (!in_bounds)
+            TraceLog (LOG_ERROR, "BUNDLE: [%s] Page %zu out of bounds", filename, i);
+
+        if (sink == NULL) {
+            rsp__defer_page (bundle, i, page, !in_bounds);
+            continue;
+        }
+
+        Image image = CLITERAL (Image){0};
+
+        if (in_bounds) {
+            image = rsp__decode_page_v2 (source, page);
+
+            if (image.data == NULL)
+                TraceLog (LOG_ERROR, "BUNDLE: [%s] Page %zu failed to decode (codec %u)", filename, i, page->codec);
+        }
+
+        sink (bundle, i, image, user);
+    }
+
+    return 1;
+}
+
+// NOTE: Returns NULL for ids that don't point at a sprite of an active bundle
+static Sprite* rsp__get_sprite (int id, SpriteBundle** bundle) {
+    if (id < 0 || RSP_SPRITE_SLOT (id) >= RSP_MAX_BUNDLES)
+        return NULL;
+
+    SpriteBundle* active = rsp__active_bundles[RSP_SPRITE_SLOT (id)];
+    if (active == NULL || RSP_SPRITE_INDEX (id) >= active->sprites_count)
+        return NULL;
+
+    if (bundle != NULL)
+        *bundle = active;
+
+    return &active->sprites[RSP_SPRITE_INDEX (id)];
+}
+
+static int rsp__find_active_sprite (const char* name) {
+    const uint64_t hash = rsp__hash (name);
+
+    for (int slot = 0; slot < RSP_MAX_BUNDLES; slot++) {
+        if (rsp__active_bundles[slot] == NULL)
+            continue;
+
+        const int index = rsp__find_sprite (rsp__active_bundles[slot], hash);
+        if (index >= 0)
+            return RSP_SPRITE_ID (slot, index);
+    }
+
+    return -1;
+}
+
+static const SpriteQuad* rsp__get_quad (int id, const SpriteBundle** bundle) {
+    SpriteBundle* active = NULL;
+    if (rsp__get_sprite (id, &active) == NULL || active->quads == NULL)
+        return NULL;
+
+    *bundle = active;
+
+    return &active->quads[RSP_SPRITE_INDEX (id)];
+}
+
+// NOTE: Box around the instance position before rotating, returns the
+// rotation in degrees. Rotated sprites are stored turned clockwise, so the box
+// follows the stored axes with the rotation turning it back
+static float rsp__quad_box (const SpriteQuad* quad, const SpriteInstance* instance, Rectangle* box) {
+    Vector2 origin = quad->origin;
+    Vector2 size   = CLITERAL (Vector2){quad->size.x * instance->scale.x, quad->size.y * instance->scale.y};
+    float rotation = instance->rotation;
+
+    if (quad->flags & RSP_SPRITE_ROTATED) {
+        size   = CLITERAL (Vector2){quad->size.x * instance->scale.y, quad->size.y * instance->scale.x};
+        origin = CLITERAL (Vector2){(quad->size.x - origin.y) * instance->scale.y, origin.x * instance->scale.x};
+
+        rotation -= 90.0f;
+    } else {
+        origin.x *= instance->scale.x;
+        origin.y *= instance->scale.y;
+    }
+
+    *box = CLITERAL (Rectangle){-origin.x, -origin.y, size.x, size.y};
+
+    return rotation;
+}
+
+// NOTE: Same corners & texture coordinates DrawTexturePro would produce
+static void rsp__quad_vertices (const SpriteQuad* quad, const SpriteInstance* instance, SpriteVertex* vertex) {
+    Rectangle box        = {0};
+    const float rotation = rsp__quad_box (quad, instance, &box);
+
+    // NOTE: Unrotated quads skip the trig, the corners come out the same
+    const float sine   = rotation != 0.0f ? sinf (rotation * DEG2RAD) : 0.0f;
+    const float cosine = rotation != 0.0f ? cosf (rotation * DEG2RAD) : 1.0f;
+
+    const float x      = instance->position.x;
+    const float y      = instance->position.y;
+    const float left   = box.x;
+    const float top    = box.y;
+    const float right  = left + box.width;
+    const float bottom = top + box.height;
+
+    vertex[0].position = CLITERAL (Vector2){x + left * cosine - top * sine, y + left * sine + top * cosine};
+    vertex[1].position = CLITERAL (Vector2){x + left * cosine - bottom * sine, y + left * sine + bottom * cosine};
+    vertex[2].position = CLITERAL (Vector2){x + right * cosine - bottom * sine, y + right * sine + bottom * cosine};
+    vertex[3].position = CLITERAL (Vector2){x + right * cosine - top * sine, y + right * sine + top * cosine};
+
+    vertex[0].texcoord = quad->uv_min;
+    vertex[1].texcoord = CLITERAL (Vector2){quad->uv_min.x, quad->uv_max.y};
+    vertex[2].texcoord = quad->uv_max;
+    vertex[3].texcoord = CLITERAL (Vector2){quad->uv_max.x, quad->uv_min.y};
+
+    vertex[0].colour = vertex[1].colour = vertex[2].colour = vertex[3].colour = instance->colour;
+}
+
+// NOTE: Nothing but the quads, whether the page can be drawn is left to
+// rsp__resolve_textures
+static void rsp__gen_vertices (const SpriteInstance* instances, size_t count, SpriteVertex* vertices) {
+    for (size_t i = 0; i < count; i++) {
+        const SpriteBundle* bundle = NULL;
+        const SpriteQuad* quad     = rsp__get_quad (instances[i].id, &bundle);
+
+        if (quad == NULL)
+            memset (&vertices[i * 4], 0, 4 * sizeof (SpriteVertex));
+        else
+            rsp__quad_vertices (quad, &instances[i], &vertices[i * 4]);
+    }
+}
+
+static void rsp__resolve_textures (const SpriteInstance* instances, size_t count, unsigned int* textures) {
+    for (size_t i = 0; i < count; i++) {
+        const SpriteBundle* bundle = NULL;
+        const SpriteQuad* quad     = rsp__get_quad (instances[i].id, &bundle);
+
+        textures[i] = quad != NULL ? rsp__use_page (bundle, quad->page) : 0;
+    }
+}
+
+// NOTE: Checked against the batch limit up front so rlgl never has to flush
+// part way through the quads
+static void rsp__submit_quads (unsigned int texture, const SpriteVertex* vertices, size_t count) {
+    rlCheckRenderBatchLimit ((int)count * 4);
+
+    rlSetTexture (texture);
+    rlBegin (RL_QUADS);
+    rlNormal3f (0.0f, 0.0f, 1.0f);
+
+    for (const SpriteVertex* vertex = vertices; vertex != vertices + count * 4; vertex++) {
+        rlColor4ub (vertex->colour.r, vertex->colour.g, vertex->colour.b, vertex->colour.a);
+        rlTexCoord2f (vertex->texcoord.x, vertex->texcoord.y);
+        rlVertex2f (vertex->position.x, vertex->position.y);
+    }
+
+    rlEnd ();
+}
+
+// -----------------------------------------------------------------------------
+// CULLING
+// -----------------------------------------------------------------------------
+
+// NOTE: Bounds of the box turned around the instance position, kept branch
+// free so the loop in rsp__cull_sprites vectorizes with it inlined
+static int rsp__box_visible (float x, float y, Rectangle box, float sine, float cosine, Rectangle view) {
+    const float centre_x = box.x + box.width * 0.5f;
+    const float centre_y = box.y + box.height * 0.5f;
+    const float half_x   = fabsf (box.width) * 0.5f;
+    const float half_y   = fabsf (box.height) * 0.5f;
+
+    x += centre_x * cosine - centre_y * sine;
+    y += centre_x * sine + centre_y * cosine;
+
+    const float extent_x = fabsf (cosine) * half_x + fabsf (sine) * half_y;
+    const float extent_y = fabsf (sine) * half_x + fabsf (cosine) * half_y;
+
+    return (x + extent_x >= view.x) & (x - extent_x <= view.x + view.width) & (y + extent_y >= view.y) & (y - extent_y <= view.y + view.height);
+}
+
+// NOTE: The lookups & trig can't vectorize, so the boxes are gathered into
+// separate arrays first and tested against the view in one straight pass.
+// Instances that wouldn't draw anyway come out hidden
+static void rsp__cull_sprites (const SpriteInstance* instances, size_t count, Rectangle view, int* visible) {
+    float x[RSP_DRAW_BATCH], y[RSP_DRAW_BATCH];
+    Rectangle boxes[RSP_DRAW_BATCH];
+    float sines[RSP_DRAW_BATCH], cosines[RSP_DRAW_BATCH];
+
+    for (size_t i = 0; i < count; i++) {
+        const SpriteBundle* bundle = NULL;
+        const SpriteQuad* quad     = rsp__get_quad (instances[i].id, &bundle);
+
+        visible[i] = quad != NULL && rsp__has_page (bundle, quad->page);
+
+        if (!visible[i]) {
+            x[i]     = y[i] = sines[i] = cosines[i] = 0.0f;
+            boxes[i] = CLITERAL (Rectangle){0};
+
+            continue;
+        }
+
+        const float rotation = rsp__quad_box (quad, &instances[i], &boxes[i]);
+
+        x[i]       = instances[i].position.x;
+        y[i]       = instances[i].position.y;
+        sines[i]   = rotation != 0.0f ? sinf (rotation * DEG2RAD) : 0.0f;
+        cosines[i] = rotation != 0.0f ? cosf (rotation * DEG2RAD) : 1.0f;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        visible[i] &= rsp__box_visible (x[i], y[i], boxes[i], sines[i], cosines[i], view);
+}
+
+// -----------------------------------------------------------------------------
+// USER METHODS
+// -----------------------------------------------------------------------------
+int GetSpriteId (const char* name) {
+    return rsp__find_active_sprite (name);
+}
+
+void GetSpriteIds (const char** names, int* ids, int count) {
+    for (int i = 0; i < count; i++)
+        ids[i] = rsp__find_active_sprite (names[i]);
+}
+
+// NOTE: Single sprites go through the batched path too, rlgl merges them with
+// whatever else is drawn from the same page
+void DrawSprite (int id, Vector2 position, Color colour) {
+    DrawSpriteEx (id, position, CLITERAL (Vector2){1.0f, 1.0f}, 0.0f, colour);
+}
+
+void DrawSpriteEx (int id, Vector2 position, Vector2 scale, float rotation, Color colour) {
+    const SpriteInstance instance = CLITERAL (SpriteInstance){id, position, scale, rotation, colour};
+
+    DrawSprites (&instance, 1);
+}
+
+void DrawSprites (const SpriteInstance* instances, size_t count) {
+    SpriteVertex vertices[RSP_DRAW_BATCH * 4];
+    unsigned int textures[RSP_DRAW_BATCH];
+
+    for (size_t start = 0; start < count; start += RSP_DRAW_BATCH) {
+        const size_t batch = count - start < RSP_DRAW_BATCH ? count - start : RSP_DRAW_BATCH;
+
+        const SpriteInstance* batch_instances = instances + start;
+        size_t drawn                          = batch;
+
+        rsp__residency.drawing = rsp__residency.clock + 1;
+
+        // NOTE: Only the visible instances get vertices, packed together so
+        // culled ones don't split up runs on the same page
+        if (rsp__culling) {
+            int visible[RSP_DRAW_BATCH];
+            rsp__cull_sprites (batch_instances, batch, rsp__cull_view, visible);
+
+            drawn = 0;
+            for (size_t i = 0; i < batch; i++) {
+                if (!visible[i])
+                    continue;
+
+                rsp__resolve_textures (&batch_instances[i], 1, &textures[drawn]);
+                rsp__gen_vertices (&batch_instances[i], 1, &vertices[drawn * 4]);
+                drawn++;
+            }
+        } else {
+            rsp__resolve_textures (batch_instances, batch, textures);
+            rsp__gen_vertices (batch_instances, batch, vertices);
+        }
+
+        for (size_t i = 0, run = 0; i < drawn; i += run) {
+            for (run = 1; i + run < drawn && textures[i + run] == textures[i];)
+                run++;
+
+            if (textures[i] != 0)
+                rsp__submit_quads (textures[i], &vertices[i * 4], run);
+        }
+
+        rsp__residency.drawing = 0;
+    }
+
+    rlSetTexture (0);
+}
+
+void GenSpriteVertices (const SpriteInstance* instances, size_t count, SpriteVertex* vertices) {
+    rsp__gen_vertices (instances, count, vertices);
+}
+
+void GetSpriteTextures (const SpriteInstance* instances, size_t count, unsigned int* textures) {
+    rsp__resolve_textures (instances, count, textures);
+}
+
+// NOTE: GetScreenToWorld2D undoes the offset, rotation & zoom, the view is the
+// box around where the screen corners land
+void SetSpriteCullCamera (Camera2D camera) {
+    const float width  = (float)GetScreenWidth ();
+    const float height = (float)GetScreenHeight ();
+
+    const Vector2 corners[4] = {
+        GetScreenToWorld2D (CLITERAL (Vector2){0.0f, 0.0f}, camera),
+        GetScreenToWorld2D (CLITERAL (Vector2){width, 0.0f}, camera),
+        GetScreenToWorld2D (CLITERAL (Vector2){0.0f, height}, camera),
+        GetScreenToWorld2D (CLITERAL (Vector2){width, height}, camera),
+    };
+
+    Vector2 min = corners[0];
+    Vector2 max = corners[0];
+
+    for (int i = 1; i < 4; i++) {
+        min = CLITERAL (Vector2){fminf (min.x, corners[i].x), fminf (min.y, corners[i].y)};
+        max = CLITERAL (Vector2){fmaxf (max.x, corners[i].x), fmaxf (max.y, corners[i].y)};
+    }
+
+    SetSpriteCullRect (CLITERAL (Rectangle){min.x, min.y, max.x - min.x, max.y - min.y});
+}
+
+void SetSpriteCullRect (Rectangle view) {
+    rsp__cull_view = view;
+    rsp__culling   = 1;
+}
+
+void DisableSpriteCulling (void) {
+    rsp__culling = 0;
+}
+
+size_t CullSprites (const SpriteInstance* instances, size_t count, Rectangle view, SpriteInstance* visible) {
+    int batch_visible[RSP_DRAW_BATCH];
+    size_t kept = 0;
+
+    for (size_t start = 0; start < count; start += RSP_DRAW_BATCH) {
+        const size_t batch = count - start < RSP_DRAW_BATCH ? count - start : RSP_DRAW_BATCH;
+
+        rsp__cull_sprites (instances + start, batch, view, batch_visible);
+
+        for (size_t i = 0; i < batch; i++) {
+            if (batch_visible[i])
+                visible[kept++] = instances[start + i];
+        }
+    }
+
+    return kept;
+}
+
+// -----------------------------------------------------------------------------
+// ANIMATION
+// -----------------------------------------------------------------------------
+// NOTE: Returns NULL unless the sprite has frames that are all in its bundle
+static const Sprite* rsp__get_animated_sprite (int id, SpriteBundle** bundle) {
+    const Sprite* sprite = rsp__get_sprite (id, bundle);
+
+    if (sprite == NULL || !(sprite->flags & RSP_SPRITE_ANIMATED) || sprite->animation.frames_count == 0
+        || (uint64_t)sprite->animation.frames_index + sprite->animation.frames_count > (*bundle)->frames_count)
+        return NULL;
+
+    return sprite;
+}
+
+static int rsp__is_animation (int animation) {
+    return animation >= 0 && animation < rsp__animations.count && rsp__animations.sprites[animation] >= 0;
+}
+
+static int rsp__grow_animations (void) {
+    const int capacity = rsp__animations.capacity > 0 ? rsp__animations.capacity * 2 : 64;
+
+#define RSP_GROW(array)                                                                               \
+    do {                                                                                              \
+        void* grown = RL_REALLOC (rsp__animations.array, capacity * sizeof (*rsp__animations.array)); \
+        if (grown == NULL)                                                                            \
+            return 0;                                                                                 \
+        rsp__animations.array = grown;                                                                \
+    } while (0)
+
+    RSP_GROW (position);
+    RSP_GROW (rate);
+    RSP_GROW (period);
+    RSP_GROW (lower);
+    RSP_GROW (upper);
+    RSP_GROW (sprites);
+    RSP_GROW (loops);
+    RSP_GROW (free);
+
+#undef RSP_GROW
+
+    rsp__animations.capacity = capacity;
+
+    return 1;
+}
+
+int PlayAnimation (int id, float speed, SpriteAnimationLoop loop) {
+    SpriteBundle* bundle = NULL;
+    const Sprite* sprite = rsp__get_animated_sprite (id, &bundle);
+    if (sprite == NULL)
+        return -1;
+
+    int animation = -1;
+
+    if (rsp__animations.free_count > 0)
+        animation = rsp__animations.free[--rsp__animations.free_count];
+    else {
+        if (rsp__animations.count == rsp__animations.capacity && !rsp__grow_animations ())
+            return -1;
+
+        animation = rsp__animations.count++;
+    }
+
+    const float frames = (float)sprite->animation.frames_count;
+
+    rsp__animations.position[animation] = 0.0f;
+    rsp__animations.sprites[animation]  = id;
+    rsp__animations.loops[animation]    = (uint8_t)loop;
+
+    rsp__animations.lower[animation] = -FLT_MAX;
+    rsp__animations.upper[animation] = FLT_MAX;
+
+    switch (loop) {
+        case ANIMATION_ONCE:
+            rsp__animations.period[animation] = FLT_MAX;
+            rsp__animations.lower[animation]  = 0.0f;
+            rsp__animations.upper[animation]  = frames;
+
+            // NOTE: Played backwards it starts on the last frame instead
+            if (speed < 0.0f)
+                rsp__animations.position[animation] = nextafterf (frames, 0.0f);
+            break;
+        case ANIMATION_PING_PONG:
+            rsp__animations.period[animation] = frames > 1.0f ? frames * 2.0f - 2.0f : 1.0f;
+            break;
+        default:
+            rsp__animations.period[animation] = frames;
+            break;
+    }
+
+    SetAnimationSpeed (animation, speed);
+
+    return animation;
+}
+
+void StopAnimation (int animation) {
+    if (!rsp__is_animation (animation))
+        return;
+
+    rsp__animations.sprites[animation] = -1;
+    rsp__animations.rate[animation]    = 0.0f;
+    rsp__animations.period[animation]  = 1.0f;
+    rsp__animations.lower[animation]   = -FLT_MAX;
+    rsp__animations.upper[animation]   = FLT_MAX;
+
+    rsp__animations.free[rsp__animations.free_count++] = animation;
+}
+
+void StopAllAnimations (void) {
+    RL_FREE (rsp__animations.position);
+    RL_FREE (rsp__animations.rate);
+    RL_FREE (rsp__animations.period);
+    RL_FREE (rsp__animations.lower);
+    RL_FREE (rsp__animations.upper);
+    RL_FREE (rsp__animations.sprites);
+    RL_FREE (rsp__animations.loops);
+    RL_FREE (rsp__animations.free);
+
+    memset (&rsp__animations, 0, sizeof (rsp__animations));
+}
+
+void SetAnimationSpeed (int animation, float speed) {
+    SpriteBundle* bundle = NULL;
+    const Sprite* sprite = rsp__is_animation (animation) ? rsp__get_animated_sprite (rsp__animations.sprites[animation], &bundle) : NULL;
+    if (sprite == NULL)
+        return;
+
+    const float fps = sprite->animation.frames_speed > 0 ? (float)sprite->animation.frames_speed : (float)RSP_ANIMATION_FPS;
+
+    rsp__animations.rate[animation] = fps * speed;
+}
+
+int GetAnimationFrame (int animation) {
+    SpriteBundle* bundle = NULL;
+    const Sprite* sprite = rsp__is_animation (animation) ? rsp__get_animated_sprite (rsp__animations.sprites[animation], &bundle) : NULL;
+    if (sprite == NULL)
+        return -1;
+
+    const int frames_count = sprite->animation.frames_count;
+    int frame              = (int)rsp__animations.position[animation];
+
+    // NOTE: Ping pong plays the way back as the second half of the cycle,
+    // without repeating either end
+    if (rsp__animations.loops[animation] == ANIMATION_PING_PONG && frame >= frames_count)
+        frame = 2 * frames_count - 2 - frame;
+
+    return frame < 0 ? 0 : (frame >= frames_count ? frames_count - 1 : frame);
+}
+
+int IsAnimationFinished (int animation) {
+    if (!rsp__is_animation (animation))
+        return 1;
+
+    if (rsp__animations.loops[animation] != ANIMATION_ONCE)
+        return 0;
+
+    return rsp__animations.rate[animation] < 0.0f ? rsp__animations.position[animation] <= rsp__animations.lower[animation]
+                                                   : rsp__animations.position[animation] >= rsp__animations.upper[animation];
+}
+
+// NOTE: One pass over flat arrays with no branches the compiler can't turn
+// into selects, the frame itself is only worked out when it's asked for
+void UpdateAnimations (float delta) {
+    float* position     = rsp__animations.position;
+    const float* rate   = rsp__animations.rate;
+    const float* period = rsp__animations.period;
+    const float* lower  = rsp__animations.lower;
+    const float* upper  = rsp__animations.upper;
+    const int count     = rsp__animations.count;
+
+    for (int i = 0; i < count; i++) {
+        float next = position[i] + delta * rate[i];
+
+        next = next > lower[i] ? next : lower[i];
+        next = next < upper[i] ? next : upper[i];
+
+        // NOTE: Floored by hand, floorf keeps GCC from vectorizing the loop
+        // unless trapping math is turned off
+        const float cycles = next / period[i];
+        float whole        = (float)(int)cycles;
+        whole += whole > cycles ? -1.0f : 0.0f;
+
+        position[i] = next - whole * period[i];
+    }
+}
+
+void DrawAnimation (int animation, Vector2 position, Color colour) {
+    DrawAnimationEx (animation, position, CLITERAL (Vector2){1.0f, 1.0f}, 0.0f, colour);
+}
+
+// NOTE: Frames are untrimmed rects on the page, so they go around the
+// sprite's own origin rather than the trimmed one of its quad. Frames of
+// rotated sprites are stored turned the same way the sprite is. Texture
+// coordinates stay empty until the page has a size
+static SpriteQuad rsp__frame_quad (const SpriteBundle* bundle, int id, int frame) {
+    const Sprite* sprite   = &bundle->sprites[RSP_SPRITE_INDEX (id)];
+    const Rectangle source = bundle->frames[sprite->animation.frames_index + frame];
+    const Vector2 page     = bundle->page_sizes[sprite->page];
+
+    SpriteQuad quad = CLITERAL (SpriteQuad){
+        .size   = CLITERAL (Vector2){source.width, source.height},
+        .origin = sprite->origin,
+        .page   = sprite->page,
+        .flags  = sprite->flags & RSP_SPRITE_ROTATED};
+
+    if (page.x > 0.0f && page.y > 0.0f) {
+        quad.uv_min = CLITERAL (Vector2){source.x / page.x, source.y / page.y};
+        quad.uv_max = CLITERAL (Vector2){(source.x + source.width) / page.x, (source.y + source.height) / page.y};
+    }
+
+    return quad;
+}
+
+void DrawAnimationEx (int animation, Vector2 position, Vector2 scale, float rotation, Color colour) {
+    const int frame = GetAnimationFrame (animation);
+    if (frame < 0)
+        return;
+
+    const int id               = rsp__animations.sprites[animation];
+    const SpriteBundle* bundle = NULL;
+    const SpriteQuad* quad     = rsp__get_quad (id, &bundle);
+
+    if (quad == NULL || !rsp__has_page (bundle, quad->page))
+        return;
+
+    SpriteQuad frame_quad         = rsp__frame_quad (bundle, id, frame);
+    const SpriteInstance instance = CLITERAL (SpriteInstance){id, position, scale, rotation, colour};
+    SpriteVertex vertices[4];
+
+    if (rsp__culling) {
+        Rectangle box     = {0};
+        const float angle = rsp__quad_box (&frame_quad, &instance, &box) * DEG2RAD;
+
+        if (!rsp__box_visible (position.x, position.y, box, sinf (angle), cosf (angle), rsp__cull_view))
+            return;
+    }
+
+    // NOTE: Deferred pages are only loaded once the frame is known to be seen,
+    // v1 ones only have a size after that
+    const unsigned int texture = rsp__use_page (bundle, quad->page);
+    if (texture == 0)
+        return;
+
+    frame_quad = rsp__frame_quad (bundle, id, frame);
+
+    rsp__quad_vertices (&frame_quad, &instance, vertices);
+    rsp__submit_quads (texture, vertices, 1);
+
+    rlSetTexture (0);
+}
+
+void GenAnimationVertices (int animation, Vector2 position, Vector2 scale, float rotation, Color colour, SpriteVertex* vertices) {
+    const int frame            = GetAnimationFrame (animation);
+    const int id               = frame >= 0 ? rsp__animations.sprites[animation] : -1;
+    const SpriteBundle* bundle = NULL;
+    const SpriteQuad* quad     = frame >= 0 ? rsp__get_quad (id, &bundle) : NULL;
+
+    if (quad == NULL || quad->page >= bundle->pages_count) {
+        memset (vertices, 0, 4 * sizeof (SpriteVertex));
+        return;
+    }
+
+    const SpriteQuad frame_quad   = rsp__frame_quad (bundle, id, frame);
+    const SpriteInstance instance = CLITERAL (SpriteInstance){id, position, scale, rotation, colour};
+
+    rsp__quad_vertices (&frame_quad, &instance, vertices);
+}
+
+Vector2 GetSpriteOrigin (int id) {
+    Sprite* sprite = rsp__get_sprite (id, NULL);
+    if (sprite == NULL)
+        return CLITERAL (Vector2){0, 0};
+
+    return sprite->origin;
+}
+
+void SetSpriteOrigin (int id, Vector2 origin) {
+    SpriteBundle* bundle = NULL;
+    if (rsp__get_sprite (id, &bundle) == NULL || !rsp__own_sprites (bundle))
+        return;
+    Sprite* sprite = &bundle->sprites[RSP_SPRITE_INDEX (id)];
+
+    sprite->origin = origin;
+
+    if (bundle->quads != NULL)
+        bundle->quads[RSP_SPRITE_INDEX (id)].origin = CLITERAL (Vector2){origin.x - sprite->offset.x, origin.y - sprite->offset.y};
+}
+
+Vector2 GetSpriteSize (int id) {
+    Sprite* sprite = rsp__get_sprite (id, NULL);
+    if (sprite == NULL)
+        return CLITERAL (Vector2){0, 0};
+
+    return sprite->size;
+}
+
+const char* GetSpriteName (int id) {
+    Sprite* sprite = rsp__get_sprite (id, NULL);
+    if (sprite == NULL)
+        return "null";
+
+    return sprite->name;
+}
+
+// -----------------------------------------------------------------------------
+// CORE METHODS
+// -----------------------------------------------------------------------------
+// NOTE: Everything but uploading the pages, which is left to sink or deferred
+// when there is none. Returns 0 when the bundle can't be used, whatever was
+// read is left for rsp__free_bundle
+static int rsp__read_bundle (SpriteBundle* bundle, rsp__source* bundle_info, const char* filename, rsp__page_sink sink, void* user) {
+    int result = 0;
+
+    char file_type[5] = {0};
+    rsp__read (file_type, sizeof (char), 4, bundle_info);
+
+    if (!TextIsEqual (file_type, "RSPX")) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] File was not a sprite bundle", file_type);
+        goto bundle_close;
+    }
+
+    rsp__read (&bundle->sprites_count, sizeof (uint16_t), 1, bundle_info);
+
+    // NOTE: v2 bundles zero the v1 sprite count, but so do empty v1 bundles
+    // which carry on with the page size. Only a whole v2 header that matches
+    // the file takes the v2 path
+    if (bundle->sprites_count == 0) {
+        SpriteBundleHeader header = CLITERAL (SpriteBundleHeader){0};
+
+        rsp__seek (bundle_info, 0);
+
+        if (rsp__read (&header, sizeof (SpriteBundleHeader), 1, bundle_info) == 1 && header.version >= 2
+            && header.header_size == sizeof (SpriteBundleHeader) && header.file_size == bundle_info->size) {
+            result = rsp__load_bundle_v2 (bundle, bundle_info, filename, sink, user);
+
+            goto bundle_close;
+        }
+
+        rsp__seek (bundle_info, 6);
+    }
+
+    bundle->pages_count = 1;
+    bundle->pages       = RL_CALLOC (bundle->pages_count, sizeof (Texture2D));
+    bundle->page_sizes  = RL_CALLOC (bundle->pages_count, sizeof (Vector2));
+
+    rsp__read_page_v1 (bundle, 0, bundle_info, sink, user);
+
+    bundle->sprites       = RL_CALLOC (bundle->sprites_count, sizeof (Sprite));
+    bundle->sprites_owned = 1;
+    bundle->frames_owned  = 1;
+
+    char header[HEADER_SIZE] = {0};
+
+    // NOTE: Frames aren't counted anywhere up front in v1, they grow into a
+    // scratch table that moves into the arena once everything is read
+    uint32_t frames_capacity = 0;
+
+    for (size_t i = 0; i < bundle->sprites_count; i++) {
+        rsp__read (header, sizeof (char), HEADER_SIZE, bundle_info);
+
+        if (!TextIsEqual ("SPR", header)) {
+            TraceLog (LOG_ERROR, "BUNDLE: [%s] Expected [RSP] header", header);
+            bundle->sprites_count = i;
+
+            goto bundle_close;
+        }
+
+        Sprite* sprite = &bundle->sprites[i];
+
+        rsp__read (sprite->name, sizeof (char), MAX_SPRITE_NAME_LENGTH, bundle_info);
+        rsp__read (&sprite->flags, sizeof (uint16_t), 1, bundle_info);
+
+        sprite->hash = rsp__hash (sprite->name);
+
+        // Origin
+        rsp__read (&sprite->origin.x, sizeof (float), 1, bundle_info);
+        rsp__read (&sprite->origin.y, sizeof (float), 1, bundle_info);
+
+        // Source
+        rsp__read (&sprite->source.x, sizeof (float), 1, bundle_info);
+        rsp__read (&sprite->source.y, sizeof (float), 1, bundle_info);
+        rsp__read (&sprite->source.width, sizeof (float), 1, bundle_info);
+        rsp__read (&sprite->source.height, sizeof (float), 1, bundle_info);
+
+        if (sprite->flags & RSP_SPRITE_ANIMATED) {
+            rsp__read (&sprite->animation.frames_count, sizeof (uint16_t), 1, bundle_info);
+            rsp__read (&sprite->animation.frames_speed, sizeof (uint16_t), 1, bundle_info);
+
+            sprite->animation.frames_index = bundle->frames_count;
+
+            bundle->frames_count += sprite->animation.frames_count;
+
+            if (bundle->frames_count > frames_capacity) {
+                while (frames_capacity < bundle->frames_count)
+                    frames_capacity = frames_capacity > 0 ? frames_capacity * 2 : 64;
+
+                bundle->frames = RL_REALLOC (bundle->frames, frames_capacity * sizeof (Rectangle));
+            }
+
+            for (size_t j = sprite->animation.frames_index; j < bundle->frames_count; j++) {
+                rsp__read (&bundle->frames[j].x, sizeof (float), 1, bundle_info);
+                rsp__read (&bundle->frames[j].y, sizeof (float), 1, bundle_info);
+                rsp__read (&bundle->frames[j].width, sizeof (float), 1, bundle_info);
+                rsp__read (&bundle->frames[j].height, sizeof (float), 1, bundle_info);
+            }
+        }
+
+        // Untrimmed unless the bundle says otherwise
+        sprite->size = CLITERAL (Vector2){sprite->source.width, sprite->source.height};
+    }
+
+    // NOTE: Optional chunks tacked on the end, older bundles just stop here
+    while (rsp__read (header, sizeof (char), HEADER_SIZE, bundle_info) == HEADER_SIZE) {
+        if (TextIsEqual ("PAG", header)) {
+            rsp__read (&bundle->pages_count, sizeof (uint16_t), 1, bundle_info);
+
+            for (size_t i = 0; i < bundle->sprites_count; i++)
+                rsp__read (&bundle->sprites[i].page, sizeof (uint16_t), 1, bundle_info);
+
+            bundle->pages      = RL_REALLOC (bundle->pages, bundle->pages_count * sizeof (Texture2D));
+            bundle->page_sizes = RL_REALLOC (bundle->page_sizes, bundle->pages_count * sizeof (Vector2));
+
+            for (size_t i = 1; i < bundle->pages_count; i++) {
+                bundle->pages[i]      = CLITERAL (Texture2D){0};
+                bundle->page_sizes[i] = CLITERAL (Vector2){0};
+                rsp__read_page_v1 (bundle, i, bundle_info, sink, user);
+            }
+        } else if (TextIsEqual ("TRM", header)) {
+            for (size_t i = 0; i < bundle->sprites_count; i++) {
+                Sprite* sprite = &bundle->sprites[i];
+
+                rsp__read (&sprite->offset.x, sizeof (float), 1, bundle_info);
+                rsp__read (&sprite->offset.y, sizeof (float), 1, bundle_info);
+                rsp__read (&sprite->size.x, sizeof (float), 1, bundle_info);
+                rsp__read (&sprite->size.y, sizeof (float), 1, bundle_info);
+            }
+        } else {
+            TraceLog (LOG_WARNING, "BUNDLE: [%s] Unknown chunk, skipping the rest", header);
+            break;
+        }
+    }
+
+    result = 1;
+
+bundle_close:
+    return result;
+}
+
+static int rsp__read_bundle_file (SpriteBundle* bundle, const char* filename, rsp__page_sink sink, void* user) {
+    rsp__source source = CLITERAL (rsp__source){0};
+
+    FILE* file = rsp__open_source (filename, &source);
+    if (!file) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Failed to open file", filename);
+        return 0;
+    }
+
+    int result = rsp__read_bundle (bundle, &source, filename, sink, user);
+
+    fclose (file);
+
+    return result;
+}
+
+SpriteBundle LoadBundle (const char* filename) {
+    SpriteBundle bundle = {0};
+
+    if (!rsp__read_bundle_file (&bundle, filename, rsp__upload_sink, NULL) || !rsp__finish_bundle (&bundle))
+        rsp__free_bundle (&bundle);
+
+    return bundle;
+}
+
+SpriteBundle LoadBundleFromMemory (const unsigned char* data, size_t size) {
+    SpriteBundle bundle = {0};
+    rsp__source source  = CLITERAL (rsp__source){.memory = data, .size = size};
+
+    if (!rsp__read_bundle (&bundle, &source, "memory", rsp__upload_sink, NULL) || !rsp__finish_bundle (&bundle))
+        rsp__free_bundle (&bundle);
+
+    return bundle;
+}
+
+SpriteBundle LoadBundleBaked (const char* filename, const Sprite* sprites, size_t count) {
+    SpriteBundle bundle = {0};
+    rsp__source source  = CLITERAL (rsp__source){0};
+
+    if (sprites == NULL || count == 0 || count > UINT16_MAX) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Invalid baked sprites", filename);
+        return bundle;
+    }
+
+    FILE* file = rsp__open_source (filename, &source);
+    if (!file) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Failed to open file", filename);
+        return bundle;
+    }
+
+    // NOTE: Only v2 bundles are exported with a baked header
+    SpriteBundleHeader header = CLITERAL (SpriteBundleHeader){0};
+
+    if (rsp__read (&header, sizeof (SpriteBundleHeader), 1, &source) != 1 || memcmp (header.magic, "RSPX", 4) != 0 || header.legacy_count != 0 || header.version < 2) {
+        TraceLog (LOG_ERROR, "BUNDLE: [%s] Baked sprites need a version 2 bundle", filename);
+        fclose (file);
+
+        return bundle;
+    }
+
+    bundle.sprites       = (Sprite*)sprites;
+    bundle.sprites_count = (uint16_t)count;
+    bundle.in_place      = 1;
+
+    if (!rsp__load_bundle_v2 (&bundle, &source, filename, rsp__upload_sink, NULL) || !rsp__finish_bundle (&bundle))
+        rsp__free_bundle (&bundle);
+
+    fclose (file);
+
+    return bundle;
+}
+
+SpriteBundle LoadBundleDeferred (const char* filename) {
+    SpriteBundle bundle     = {0};
+    rsp__deferred* deferred = RL_CALLOC (1, sizeof (rsp__deferred));
+
+    if (deferred == NULL || (deferred->filename = RL_MALLOC (strlen (filename) + 1)) == NULL) {
+        RL_FREE (deferred);
+        return bundle;
+    }
+
+    strcpy (deferred->filename, filename);
+    bundle.deferred = deferred;
+
+    if (!rsp__read_bundle_file (&bundle, filename, NULL, NULL) || !rsp__finish_bundle (&bundle) || !rsp__finish_deferred (&bundle))
+        rsp__free_bundle (&bundle);
+
+    return bundle;
+}
+
+void SetPageBudget (size_t bytes) {
+    rsp__residency.budget = bytes;
+
+    rsp__make_room (0);
+}
+
+size_t GetPageMemoryUsed (void) {
+    return rsp__residency.used;
+}
+
+void SetPageUploadCallbacks (PageUploadCallback upload, PageUnloadCallback unload) {
+    rsp__page_callbacks.upload = upload;
+    rsp__page_callbacks.unload = unload;
+}
+
+#if !defined(RSP_NO_THREADS)
+typedef struct rsp__bundle_job {
+    pthread_t thread;
+    pthread_mutex_t lock;
+
+    char* filename;
+    SpriteBundle bundle; // Only touched by the worker until it is joined
+
+    // Shared with the worker, guarded by lock
+    Image* images;
+    size_t images_count;
+    int dropped; // A page had nowhere to go, every page after it is dropped too
+    int finished;
+    int result;
+
+    // Main thread only
+    Texture2D* textures;
+    size_t taken; // Pages taken off images, uploaded or not
+    size_t uploaded;
+    int failed; // Ran out of room for textures, the rest are unloaded as they come
+} rsp__bundle_job;
+
+static void rsp__queue_sink (SpriteBundle* bundle, size_t index, Image image, void* user) {
+    rsp__bundle_job* job = (rsp__bundle_job*)user;
+    (void)bundle;
+
+    pthread_mutex_lock (&job->lock);
+
+    // NOTE: Pages are taken off in order, so once one is dropped the load
+    // fails and the rest would never be looked at
+    Image* images = job->dropped ? NULL : RL_REALLOC (job->images, (index + 1) * sizeof (Image));
+
+    if (images != NULL) {
+        job->images        = images;
+        job->images[index] = image;
+        job->images_count  = index + 1;
+    } else {
+        job->dropped = 1;
+        UnloadImage (image);
+    }
+
+    pthread_mutex_unlock (&job->lock);
+}
+
+static void* rsp__bundle_worker (void* data) {
+    rsp__bundle_job* job = (rsp__bundle_job*)data;
+
+    int result = rsp__read_bundle_file (&job->bundle, job->filename, rsp__queue_sink, job);
+
+    pthread_mutex_lock (&job->lock);
+    job->result   = result && !job->dropped;
+    job->finished = 1;
+    pthread_mutex_unlock (&job->lock);
+
+    return NULL;
+}
+
+// NOTE: Only once the worker has been joined, hands the uploaded pages over
+// to the bundle or unloads them when it failed. Returns 0 on failure
+static int rsp__finish_job (rsp__bundle_job* job, SpriteBundle* bundle) {
+    int result = job->result && !job->failed;
+
+    *bundle = job->bundle;
+
+    for (size_t i = 0; i < job->uploaded; i++) {
+        if (result && i < bundle->pages_count)
+            bundle->pages[i] = job->textures[i];
+        else
+            rsp__unload_page (&job->textures[i]);
+    }
+
+    result = result && rsp__finish_bundle (bundle);
+
+    if (!result)
+        rsp__free_bundle (bundle);
+
+    pthread_mutex_destroy (&job->lock);
+
+    RL_FREE (job->images);
+    RL_FREE (job->textures);
+    RL_FREE (job->filename);
+    RL_FREE (job);
+
+    return result;
+}
+
+SpriteBundle LoadBundleAsync (const char* filename) {
+    SpriteBundle bundle  = {0};
+    rsp__bundle_job* job = RL_CALLOC (1, sizeof (rsp__bundle_job));
+    char* name           = RL_MALLOC (strlen (filename) + 1);
+
+    if (job == NULL || name == NULL) {
+        TraceLog (LOG_WARNING, "BUNDLE: [%s] Failed to allocate loading job, loading in place", filename);
+
+        RL_FREE (name);
+        RL_FREE (job);
+
+        return LoadBundle (filename);
+    }
+
+    job->filename = strcpy (name, filename);
+
+    pthread_mutex_init (&job->lock, NULL);
+
+    if (pthread_create (&job->thread, NULL, rsp__bundle_worker, job) != 0) {
+        TraceLog (LOG_WARNING, "BUNDLE: [%s] Failed to start loading thread, loading in place", filename);
+
+        pthread_mutex_destroy (&job->lock);
+        RL_FREE (job->filename);
+        RL_FREE (job);
+
+        return LoadBundle (filename);
+    }
+
+    bundle.job = job;
+
+    return bundle;
+}
+
+// NOTE: Pages are uploaded as they come in rather than all at the end, so the
+// upload cost is spread over however many frames the decode takes
+int PollBundle (SpriteBundle* bundle) {
+    rsp__bundle_job* job = (rsp__bundle_job*)bundle->job;
+
+    if (job == NULL)
+        return bundle->id > 0 ? 1 : -1;
+
+    int finished = 0;
+
+    for (;;) {
+        pthread_mutex_lock (&job->lock);
+
+        const int pending = job->taken < job->images_count;
+        const Image image = pending ? job->images[job->taken] : CLITERAL (Image){0};
+
+        finished = job->finished;
+
+        pthread_mutex_unlock (&job->lock);
+
+        if (!pending)
+            break;
+
+        job->taken++;
+
+        Texture2D* textures = job->failed ? NULL : RL_REALLOC (job->textures, (job->uploaded + 1) * sizeof (Texture2D));
+
+        if (textures == NULL) {
+            if (!job->failed)
+                TraceLog (LOG_WARNING, "BUNDLE: [%s] Failed to allocate page textures", job->filename);
+
+            job->failed = 1;
+            UnloadImage (image);
+
+            continue;
+        }
+
+        job->textures                  = textures;
+        job->textures[job->uploaded++] = rsp__upload_page (image);
+    }
+
+    if (!finished)
+        return 0;
+
+    pthread_join (job->thread, NULL);
+
+    return rsp__finish_job (job, bundle) ? 1 : -1;
+}
+#else
+SpriteBundle LoadBundleAsync (const char* filename) {
+    return LoadBundle (filename);
+}
+
+int PollBundle (SpriteBundle* bundle) {
+    return bundle->id > 0 ? 1 : -1;
+}
+#endif // RSP_NO_THREADS
+
+// -----------------------------------------------------------------------------
+// HOT RELOAD
+// -----------------------------------------------------------------------------
+// NOTE: Reorders a freshly loaded bundle so every sprite that was in the
+// previous one sits at its old index, new sprites go on the end and removed
+// ones leave an empty sprite behind. The arena is rebuilt to fit
+static int rsp__keep_sprite_ids (SpriteBundle* bundle, const Sprite* previous, uint16_t previous_count) {
+    uint8_t* kept = RL_CALLOC (bundle->sprites_count + 1, sizeof (uint8_t));
+    if (kept == NULL)
+        return 0;
+
+    size_t count = previous_count;
+
+    for (size_t i = 0; i < previous_count; i++) {
+        const int index = previous[i].hash != 0 ? rsp__find_sprite (bundle, previous[i].hash) : -1;
+        if (index >= 0)
+            kept[index] = 1;
+    }
+
+    for (size_t i = 0; i < bundle->sprites_count; i++)
+        count += !kept[i];
+
+    // NOTE: Removed sprites hold on to their ids, enough churn runs out of them
+    if (count > UINT16_MAX) {
+        TraceLog (LOG_ERROR, "BUNDLE: [ID %d] Keeping ids needs %zu sprites, more than ids can hold", bundle->id, count);
+        RL_FREE (kept);
+
+        return 0;
+    }
+
+    Sprite* sprites   = RL_CALLOC (count + 1, sizeof (Sprite));
+    Texture2D* pages  = RL_MALLOC ((bundle->pages_count + 1) * sizeof (Texture2D));
+    Vector2* sizes    = RL_MALLOC ((bundle->pages_count + 1) * sizeof (Vector2));
+    Rectangle* frames = RL_MALLOC ((bundle->frames_count + 1) * sizeof (Rectangle));
+
+    if (sprites == NULL || pages == NULL || sizes == NULL || frames == NULL) {
+        RL_FREE (kept);
+        RL_FREE (sprites);
+        RL_FREE (pages);
+        RL_FREE (sizes);
+        RL_FREE (frames);
+
+        return 0;
+    }
+
+    for (size_t i = 0; i < previous_count; i++) {
+        const int index = previous[i].hash != 0 ? rsp__find_sprite (bundle, previous[i].hash) : -1;
+        if (index >= 0)
+            sprites[i] = bundle->sprites[index];
+    }
+
+    for (size_t i = 0, next = previous_count; i < bundle->sprites_count; i++) {
+        if (!kept[i])
+            sprites[next++] = bundle->sprites[i];
+    }
+
+    RL_FREE (kept);
+
+    // NOTE: Pages & frames may live in the arena or data that's about to go, so
+    // they come out first and get moved into the new arena
+    memcpy (pages, bundle->pages, bundle->pages_count * sizeof (Texture2D));
+    memcpy (sizes, bundle->page_sizes, bundle->pages_count * sizeof (Vector2));
+    if (bundle->frames_count > 0)
+        memcpy (frames, bundle->frames, bundle->frames_count * sizeof (Rectangle));
+
+    if (bundle->sprites_owned)
+        RL_FREE (bundle->sprites);
+
+    if (bundle->frames_owned)
+        RL_FREE (bundle->frames);
+
+    if (bundle->data != NULL)
+        rsp__unmap_file (bundle->data, bundle->data_size, bundle->data_mapped);
+
+    RL_FREE (bundle->arena);
+
+    bundle->data          = NULL;
+    bundle->arena         = NULL;
+    bundle->pages         = pages;
+    bundle->page_sizes    = sizes;
+    bundle->sprites       = sprites;
+    bundle->sprites_count = (uint16_t)count;
+    bundle->sprites_owned = 1;
+    bundle->frames        = frames;
+    bundle->frames_owned  = 1;
+    bundle->in_place      = 0;
+
+    if (!rsp__alloc_arena (bundle))
+        return 0;
+
+    // NOTE: Deferred pages are loaded straight into the arena, which just moved
+    rsp__deferred* deferred = (rsp__deferred*)bundle->deferred;
+
+    if (deferred != NULL) {
+        deferred->textures = bundle->pages;
+        deferred->sizes    = bundle->page_sizes;
+    }
+
+    rsp__build_index (bundle);
+    rsp__build_quads (bundle);
+
+    return 1;
+}
+
+// NOTE: The bundle stays where it is so active slots & watches pointing at it
+// carry on, the old pages & tables are released straight after
+static int rsp__swap_bundle (SpriteBundle* bundle, SpriteBundle* fresh) {
+    if (!rsp__keep_sprite_ids (fresh, bundle->sprites, bundle->sprites_count)) {
+        TraceLog (LOG_WARNING, "BUNDLE: [ID %d] Failed to keep sprite ids, keeping the loaded bundle", bundle->id);
+        UnloadBundle (*fresh);
+
+        return 0;
+    }
+
+    SpriteBundle previous = *bundle;
+
+    *bundle    = *fresh;
+    bundle->id = previous.id;
+
+    rsp__free_bundle (&previous);
+
+    TraceLog (LOG_INFO, "BUNDLE: [ID %d] Sprite bundle reloaded", bundle->id);
+
+    return 1;
+}
+
+// NOTE: Files written over in place show through a private mapping, which
+// would change the tables under a watched bundle (or fault once truncated),
+// so watched bundles keep a copy of them instead
+static int rsp__detach_tables (SpriteBundle* bundle) {
+    if (!bundle->data_mapped)
+        return 1;
+
+    unsigned char* data = RL_MALLOC (bundle->data_size);
+    if (data == NULL)
+        return 0;
+
+    memcpy (data, bundle->data, bundle->data_size);
+
+    // NOTE: Baked sprites were never in the mapping to begin with
+    if (!bundle->sprites_owned && !bundle->in_place && bundle->sprites != NULL)
+        bundle->sprites = (Sprite*)(data + ((unsigned char*)bundle->sprites - (unsigned char*)bundle->data));
+
+    if (!bundle->frames_owned && bundle->frames != NULL)
+        bundle->frames = (Rectangle*)(data + ((unsigned char*)bundle->frames - (unsigned char*)bundle->data));
+
+    rsp__unmap_file (bundle->data, bundle->data_size, bundle->data_mapped);
+
+    bundle->data        = data;
+    bundle->data_mapped = 0;
+
+    return 1;
+}
+
+static void rsp__clear_watch (rsp__watch* watch) {
+    if (watch->reloading)
+        UnloadBundle (watch->reload);
+
+#if defined(__linux__)
+    // NOTE: Watches on the same directory share a descriptor
+    int shared = 0;
+    for (int i = 0; i < RSP_MAX_BUNDLES; i++)
+        shared |= &rsp__watches[i] != watch && rsp__watches[i].bundle != NULL && rsp__watches[i].descriptor == watch->descriptor;
+
+    if (watch->descriptor >= 0 && !shared)
+        inotify_rm_watch (rsp__watch_events, watch->descriptor);
+#endif
+
+    RL_FREE (watch->filename);
+
+    *watch = CLITERAL (rsp__watch){0};
+}
+
+// NOTE: Watches the directory rather than the file, so files replaced by a
+// rename are still picked up
+static int rsp__add_watch (rsp__watch* watch) {
+#if defined(__linux__)
+    if (rsp__watch_events < 0)
+        rsp__watch_events = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+    if (rsp__watch_events < 0)
+        return -1;
+
+    const size_t directory_length = watch->name - watch->filename;
+    char* directory               = RL_MALLOC (directory_length + 2);
+
+    if (directory_length > 0)
+        memcpy (directory, watch->filename, directory_length);
+    else
+        directory[0] = '.';
+
+    directory[directory_length > 0 ? directory_length : 1] = '\0';
+
+    const int descriptor = inotify_add_watch (rsp__watch_events, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    RL_FREE (directory);
+
+    return descriptor;
+#else
+    (void)watch;
+
+    return -1;
+#endif
+}
+
+static void rsp__read_watch_events (void) {
+#if defined(__linux__)
+    if (rsp__watch_events < 0)
+        return;
+
+    char buffer[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+    ssize_t length = 0;
+
+    while ((length = read (rsp__watch_events, buffer, sizeof (buffer))) > 0) {
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+
+            for (int i = 0; i < RSP_MAX_BUNDLES; i++) {
+                rsp__watch* watch = &rsp__watches[i];
+
+                if (watch->bundle != NULL && watch->descriptor == event->wd && event->len > 0 && strcmp (event->name, watch->name) == 0)
+                    watch->changed = 1;
+            }
+
+            p += sizeof (struct inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+void WatchBundle (SpriteBundle* bundle, const char* filename) {
+    UnwatchBundle (bundle);
+
+    rsp__watch* watch = NULL;
+    for (int i = 0; i < RSP_MAX_BUNDLES && watch == NULL; i++) {
+        if (rsp__watches[i].bundle == NULL)
+            watch = &rsp__watches[i];
+    }
+
+    if (watch == NULL) {
+        TraceLog (LOG_WARNING, "BUNDLE: [%s] No free watches (%d)", filename, RSP_MAX_BUNDLES);
+        return;
+    }
+
+    if (!rsp__detach_tables (bundle)) {
+        TraceLog (LOG_WARNING, "BUNDLE: [%s] Failed to copy the tables, not watching", filename);
+        return;
+    }
+
+    watch->filename = RL_MALLOC (strlen (filename) + 1);
+    strcpy (watch->filename, filename);
+
+    const char* separator = strrchr (watch->filename, '/');
+#if defined(_WIN32)
+    if (strrchr (watch->filename, '\\') > separator)
+        separator = strrchr (watch->filename, '\\');
+#endif
+
+    watch->bundle     = bundle;
+    watch->name       = separator != NULL ? separator + 1 : watch->filename;
+    watch->descriptor = rsp__add_watch (watch);
+    watch->modified   = GetFileModTime (filename);
+    watch->length     = GetFileLength (filename);
+    watch->checked    = GetTime ();
+
+    TraceLog (LOG_INFO, "BUNDLE: [%s] Watching for changes (%s)", filename, watch->descriptor >= 0 ? "inotify" : "polling");
+}
+
+void UnwatchBundle (SpriteBundle* bundle) {
+    for (int i = 0; i < RSP_MAX_BUNDLES; i++) {
+        if (rsp__watches[i].bundle == bundle)
+            rsp__clear_watch (&rsp__watches[i]);
+    }
+}
+
+int UpdateBundleWatches (void) {
+    int swapped = 0;
+
+    rsp__read_watch_events ();
+
+    const double now = GetTime ();
+
+    for (int i = 0; i < RSP_MAX_BUNDLES; i++) {
+        rsp__watch* watch = &rsp__watches[i];
+        if (watch->bundle == NULL)
+            continue;
+
+        // NOTE: Length is checked too, a write landing within the same second
+        // as the last one leaves the modified time alone
+        if (watch->descriptor < 0 && now - watch->checked >= RSP_WATCH_INTERVAL) {
+            const long modified = GetFileModTime (watch->filename);
+            const int length    = GetFileLength (watch->filename);
+
+            watch->changed |= modified != watch->modified || length != watch->length;
+            watch->modified = modified;
+            watch->length   = length;
+            watch->checked  = now;
+        }
+
+        // NOTE: Changes while a reload is running start another once it's done.
+        // Deferred bundles stay deferred, only their tables are read up front
+        // so there is nothing to gain from a worker
+        if (watch->changed && !watch->reloading) {
+            TraceLog (LOG_INFO, "BUNDLE: [%s] Changed, reloading", watch->filename);
+
+            watch->changed   = 0;
+            watch->reloading = 1;
+            watch->reload    = watch->bundle->deferred != NULL ? LoadBundleDeferred (watch->filename) : LoadBundleAsync (watch->filename);
+        }
+
+        if (!watch->reloading)
+            continue;
+
+        const int state = PollBundle (&watch->reload);
+        if (state == 0)
+            continue;
+
+        watch->reloading = 0;
+
+        if (state < 0)
+            TraceLog (LOG_WARNING, "BUNDLE: [%s] Reload failed, keeping the loaded bundle", watch->filename);
+        else
+            swapped += rsp__swap_bundle (watch->bundle, &watch->reload);
+
+        watch->reload = CLITERAL (SpriteBundle){0};
+    }
+
+    return swapped;
+}
+
+void SetActiveBundle (SpriteBundle* bundle) {
+    for (int slot = 0; slot < RSP_MAX_BUNDLES; slot++)
+        rsp__active_bundles[slot] = NULL;
+
+    rsp__active_bundles[0] = bundle;
+}
+
+// NOTE: Freed slots are reused, ids from a removed bundle end up pointing at
+// whichever bundle is added next
+int AddActiveBundle (SpriteBundle* bundle) {
+    int free_slot = -1;
+
+    for (int slot = 0; slot < RSP_MAX_BUNDLES; slot++) {
+        if (rsp__active_bundles[slot] == bundle)
+            return slot;
+
+        if (rsp__active_bundles[slot] == NULL && free_slot < 0)
+            free_slot = slot;
+    }
+
+    if (free_slot < 0) {
+        TraceLog (LOG_WARNING, "BUNDLE: [ID %d] No free active bundle slots (%d)", bundle->id, RSP_MAX_BUNDLES);
+        return -1;
+    }
+
+    rsp__active_bundles[free_slot] = bundle;
+
+    return free_slot;
+}
+
+void RemoveActiveBundle (SpriteBundle* bundle) {
+    for (int slot = 0; slot < RSP_MAX_BUNDLES; slot++) {
+        if (rsp__active_bundles[slot] == bundle)
+            rsp__active_bundles[slot] = NULL;
+    }
+}
+
+int IsBundleReady (SpriteBundle bundle) {
+    int result = 0;
+
+    if ((bundle.sprites_count != 0) && (bundle.pages_count != 0)) {
+        result = 1;
+
+        // NOTE: Deferred pages are ready as long as they haven't failed to load
+        for (size_t i = 0; i < bundle.pages_count; i++)
+            result &= IsTextureReady (bundle.pages[i]) || rsp__has_page (&bundle, (uint16_t)i);
+    }
+
+    return result;
+}
+
+void UnloadBundle (SpriteBundle bundle) {
+#if !defined(RSP_NO_THREADS)
+    // NOTE: Still loading, wait the worker out and throw away what it made
+    if (bundle.job != NULL) {
+        rsp__bundle_job* job = (rsp__bundle_job*)bundle.job;
+
+        pthread_join (job->thread, NULL);
+
+        for (size_t i = job->taken; i < job->images_count; i++)
+            UnloadImage (job->images[i]);
+
+        job->result = 0;
+        rsp__finish_job (job, &bundle);
+
+        return;
+    }
+#endif
+
+    TraceLog (LOG_INFO, "BUNDLE: [ID %d] Sprite bundle unloaded successfully", bundle.id);
+
+    // NOTE: Only a copy is passed in, the page array is what ties it to the
+    // bundle it was registered with since no two bundles share one
+    for (int slot = 0; slot < RSP_MAX_BUNDLES; slot++) {
+        if (bundle.pages != NULL && rsp__active_bundles[slot] != NULL && rsp__active_bundles[slot]->pages == bundle.pages)
+            rsp__active_bundles[slot] = NULL;
+
+        if (bundle.pages != NULL && rsp__watches[slot].bundle != NULL && rsp__watches[slot].bundle->pages == bundle.pages)
+            rsp__clear_watch (&rsp__watches[slot]);
+    }
 
-    rsp__bundles_loaded--;
+    rsp__free_bundle (&bundle);
 }
 
 #undef HEADER_SIZE
+#undef RSP_DRAW_BATCH
 
 #undef RSP_SPRITE_ANIMATED
 #undef RSP_SPRITE_ORIGIN
+#undef RSP_SPRITE_ROTATED
 
 #endif // RSP_IMPLEMENTATION
 
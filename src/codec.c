@@ -0,0 +1,235 @@
+// -----------------------------------------------------------------------------
+// Codec
+//
+// Both encoders are single pass and greedy, they run once per export so the
+// effort goes into keeping the decoders in rsp.h simple and fast instead.
+// -----------------------------------------------------------------------------
+#include "codec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ4_HASH_BITS     16
+#define LZ4_MIN_MATCH     4
+#define LZ4_MAX_OFFSET    65535
+#define LZ4_LAST_LITERALS 5  // Block has to end with at least this many literals
+#define LZ4_MATCH_LIMIT   12 // No match may start closer to the end than this
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+
+#define QOI_HEADER_SIZE 14
+#define QOI_END_SIZE    8
+
+// -----------------------------------------------------------------------------
+// LZ4
+// -----------------------------------------------------------------------------
+static uint32_t Read32 (const uint8_t* data) {
+    uint32_t value;
+    memcpy (&value, data, sizeof (uint32_t));
+
+    return value;
+}
+
+static uint32_t HashSequence (uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+// Remainder of a length that didn't fit in its token nibble
+static uint8_t* WriteLength (uint8_t* out, size_t length) {
+    for (; length >= 255; length -= 255)
+        *out++ = 255;
+
+    *out++ = (uint8_t)length;
+
+    return out;
+}
+
+// NOTE: A match length of 0 writes the closing literals only sequence, returns
+// NULL when the worst case for the sequence would run past end
+static uint8_t* WriteSequence (uint8_t* out, const uint8_t* end, const uint8_t* literals, size_t literals_length, size_t offset, size_t match_length) {
+    if ((size_t)(end - out) < 1 + literals_length / 255 + 1 + literals_length + 2 + match_length / 255 + 1)
+        return NULL;
+
+    size_t match_code = match_length > 0 ? match_length - LZ4_MIN_MATCH : 0;
+    uint8_t* token    = out++;
+
+    *token = (uint8_t)(((literals_length < 15 ? literals_length : 15) << 4) | (match_code < 15 ? match_code : 15));
+
+    if (literals_length >= 15)
+        out = WriteLength (out, literals_length - 15);
+
+    memcpy (out, literals, literals_length);
+    out += literals_length;
+
+    if (match_length == 0)
+        return out;
+
+    *out++ = (uint8_t)(offset & 0xFF);
+    *out++ = (uint8_t)(offset >> 8);
+
+    if (match_code >= 15)
+        out = WriteLength (out, match_code - 15);
+
+    return out;
+}
+
+size_t RSP_GetLZ4Bound (size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t RSP_EncodeLZ4 (const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    // NOTE: Positions are stored one higher so a zeroed table reads as empty
+    uint32_t* table = calloc ((size_t)1 << LZ4_HASH_BITS, sizeof (uint32_t));
+    if (table == NULL)
+        return 0;
+
+    const uint8_t* end = dst + capacity;
+    uint8_t* out       = dst;
+
+    size_t anchor = 0;
+    size_t ip     = 0;
+    size_t misses = 0;
+
+    while (out != NULL && ip + LZ4_MATCH_LIMIT < size) {
+        uint32_t sequence = Read32 (src + ip);
+        uint32_t hash     = HashSequence (sequence);
+        size_t candidate  = table[hash];
+
+        table[hash] = (uint32_t)(ip + 1);
+
+        // NOTE: Skips further ahead the longer nothing matches, incompressible
+        // areas like noisy sprites would otherwise be hashed a byte at a time
+        if (candidate == 0 || ip - (candidate - 1) > LZ4_MAX_OFFSET || Read32 (src + candidate - 1) != sequence) {
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+
+        candidate -= 1;
+        misses = 0;
+
+        while (ip > anchor && candidate > 0 && src[ip - 1] == src[candidate - 1]) {
+            ip--;
+            candidate--;
+        }
+
+        size_t length = LZ4_MIN_MATCH;
+        while (ip + length < size - LZ4_LAST_LITERALS && src[ip + length] == src[candidate + length])
+            length++;
+
+        out = WriteSequence (out, end, src + anchor, ip - anchor, ip - candidate, length);
+
+        ip += length;
+        anchor = ip;
+
+        if (ip + LZ4_MATCH_LIMIT < size)
+            table[HashSequence (Read32 (src + ip - 2))] = (uint32_t)(ip - 2 + 1);
+    }
+
+    if (out != NULL)
+        out = WriteSequence (out, end, src + anchor, size - anchor, 0, 0);
+
+    free (table);
+
+    return out != NULL ? (size_t)(out - dst) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// QOI
+// -----------------------------------------------------------------------------
+static int HashPixel (const uint8_t* pixel) {
+    return (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+}
+
+static uint8_t* Write32BE (uint8_t* out, uint32_t value) {
+    *out++ = (uint8_t)(value >> 24);
+    *out++ = (uint8_t)(value >> 16);
+    *out++ = (uint8_t)(value >> 8);
+    *out++ = (uint8_t)value;
+
+    return out;
+}
+
+size_t RSP_GetQOIBound (int width, int height) {
+    return (size_t)width * height * 5 + QOI_HEADER_SIZE + QOI_END_SIZE;
+}
+
+size_t RSP_EncodeQOI (const uint8_t* pixels, int width, int height, uint8_t* dst, size_t capacity) {
+    if (capacity < RSP_GetQOIBound (width, height))
+        return 0;
+
+    uint8_t* out = dst;
+
+    memcpy (out, "qoif", 4);
+    out    = Write32BE (out + 4, (uint32_t)width);
+    out    = Write32BE (out, (uint32_t)height);
+    *out++ = 4; // Channels
+    *out++ = 0; // sRGB with linear alpha
+
+    uint8_t index[64][4] = {{0}};
+    uint8_t previous[4]  = {0, 0, 0, 255};
+
+    const size_t count = (size_t)width * height;
+    int run            = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* pixel = pixels + i * 4;
+
+        if (memcmp (pixel, previous, 4) == 0) {
+            if (++run == 62 || i == count - 1) {
+                *out++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+                run    = 0;
+            }
+
+            continue;
+        }
+
+        if (run > 0) {
+            *out++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+            run    = 0;
+        }
+
+        int hash = HashPixel (pixel);
+
+        if (memcmp (index[hash], pixel, 4) == 0)
+            *out++ = (uint8_t)(QOI_OP_INDEX | hash);
+        else {
+            memcpy (index[hash], pixel, 4);
+
+            if (pixel[3] == previous[3]) {
+                int8_t dr = (int8_t)(pixel[0] - previous[0]);
+                int8_t dg = (int8_t)(pixel[1] - previous[1]);
+                int8_t db = (int8_t)(pixel[2] - previous[2]);
+
+                int8_t dr_dg = (int8_t)(dr - dg);
+                int8_t db_dg = (int8_t)(db - dg);
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                    *out++ = (uint8_t)(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7) {
+                    *out++ = (uint8_t)(QOI_OP_LUMA | (dg + 32));
+                    *out++ = (uint8_t)((dr_dg + 8) << 4 | (db_dg + 8));
+                } else {
+                    *out++ = QOI_OP_RGB;
+                    memcpy (out, pixel, 3);
+                    out += 3;
+                }
+            } else {
+                *out++ = QOI_OP_RGBA;
+                memcpy (out, pixel, 4);
+                out += 4;
+            }
+        }
+
+        memcpy (previous, pixel, 4);
+    }
+
+    memcpy (out, "\0\0\0\0\0\0\0\1", QOI_END_SIZE);
+    out += QOI_END_SIZE;
+
+    return (size_t)(out - dst);
+}
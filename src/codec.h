@@ -0,0 +1,28 @@
+// -----------------------------------------------------------------------------
+// Codec
+//
+// Encoders for the atlas page payloads, the matching decoders live in rsp.h.
+// Both take tightly packed R8G8B8A8 pixels and write into a buffer the caller
+// sized with the bound function.
+// -----------------------------------------------------------------------------
+#ifndef RSP_CODEC_H
+#define RSP_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Function decleration
+// -----------------------------------------------------------------------------
+
+// LZ4 block format, readable by any LZ4 block decoder. Returns the number of
+// bytes written, or 0 when it didn't fit
+size_t RSP_GetLZ4Bound (size_t size);
+size_t RSP_EncodeLZ4 (const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+
+// QOI image, header & end marker included. Returns the number of bytes written,
+// or 0 when it didn't fit
+size_t RSP_GetQOIBound (int width, int height);
+size_t RSP_EncodeQOI (const uint8_t* pixels, int width, int height, uint8_t* dst, size_t capacity);
+
+#endif // RSP_CODEC_H
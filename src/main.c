@@ -10,9 +10,16 @@
 #include <raylib.h>
 #include <raymath.h>
 
+#include <ctype.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <sys/stat.h>
 
+#include <rsp.h>
+
+#include "codec.h"
+#include "packer.h"
+#include "pixels.h"
 #include "vendor/parson.h"
 
 // -----------------------------------------------------------------------------
@@ -28,12 +35,22 @@
 #define MAX_ASSET_FILE_LENGTH 64
 
 #define MAX_PROJECT_NAME_LENGTH 32
+#define MAX_FILE_PATH_LENGTH    512
 
 #define DEFAULT_PROJECT_DIRECTORY "projects"
 #define DEFAULT_PROJECT_EXTENSION ".rspp"
 #define DEFAULT_PROJECT_VERSION   1
 
 #define DEFAULT_BUNDLE_EXTENSION ".rspx"
+#define DEFAULT_BUNDLE_CODEC     BUNDLE_CODEC_LZ4
+
+#define DEFAULT_PACK_THREADS     0 // One per core
+#define DEFAULT_INSERT_HEURISTIC RSP_PACK_BEST_SHORT_SIDE
+
+#define ATLAS_PAGE_SPACING 32
+
+#define MAX_ATLAS_SIZE 8192 // Largest page the auto size searches up to
+#define MIN_ATLAS_SIZE 64   // Page an empty auto sized project starts with
 
 // -----------------------------------------------------------------------------
 // Macros
@@ -42,6 +59,9 @@
 
 #define lengthof(x) (sizeof (x) / sizeof (x[0]))
 
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
 #ifdef _WIN32
 #define MakeDirectory(x) _mkdir (x)
 #else
@@ -54,6 +74,7 @@
 typedef enum RSP_SpriteFlags {
     RSP_SPRITE_ANIMATED = 1 << 0,
     RSP_SPRITE_ORIGIN   = 1 << 1,
+    RSP_SPRITE_ROTATED  = 1 << 2,
 } RSP_SpriteFlags;
 
 typedef enum RSP_ProjectError {
@@ -77,12 +98,19 @@ typedef struct RSP_Sprite {
     char name[MAX_ASSET_NAME_LENGTH];
     char file[MAX_ASSET_FILE_LENGTH];
     uint16_t flags;
+    uint16_t page;
 
-    Texture2D texture;
+    Image image; // Decoded RGBA8 pixels, only loaded for unique sprites
 
-    Rectangle source;
+    Rectangle source; // Rect on the page, width & height swap when rotated
     Vector2 origin;
 
+    Vector2 offset; // Transparent border trimmed from the top left
+    Vector2 size;   // Size before trimming
+
+    uint64_t hash; // Trimmed pixels, used to find duplicates
+    int32_t alias; // Sprite with identical pixels this one shares, -1 if unique
+
     struct {
         Rectangle* frames;
         uint16_t frames_count;
@@ -96,12 +124,26 @@ typedef struct RSP_Project {
     char name[MAX_PROJECT_NAME_LENGTH];
 
     bool should_embed_files;
+    bool allow_rotation;
 
     RSP_Sprite* sprites;
     uint16_t sprites_count;
 
-    RenderTexture2D atlas;
-    uint16_t atlas_size;
+    Image* pages;              // Composited on the CPU, what gets exported
+    Texture2D* page_previews; // Uploaded copies of pages, only with a window
+    uint16_t pages_count;
+
+    RSP_Packer* packers; // One per page, only built once sprites are inserted
+
+    uint16_t atlas_size; // Largest page size allowed, fixed unless auto sized
+    uint16_t atlas_width;
+    uint16_t atlas_height;
+
+    bool auto_atlas_size;
+    bool allow_non_square;
+
+    uint8_t codec; // SpriteBundleCodec pages are exported with
+
     FilePathList assets;
 } RSP_Project;
 
@@ -128,8 +170,25 @@ typedef struct RSP_WidgetWelcome {
 
     bool value_atlas_align_edit;
     int value_atlas_align;
+
+    bool checkbox_allow_rotation_checked;
+    bool checkbox_non_square_checked;
+
+    bool dropdown_codec_edit;
+    int dropdown_codec_active;
 } RSP_WidgetWelcome;
 
+typedef struct RSP_BuildQueue {
+    const char** projects;
+    int projects_count;
+
+    const char* output_directory; // Next to each project file when NULL
+
+    pthread_mutex_t lock;
+    int next_project;
+    int failed_count;
+} RSP_BuildQueue;
+
 typedef struct RSP_WidgetToolbar {
     bool active;
     Vector2 anchor;
@@ -137,6 +196,7 @@ typedef struct RSP_WidgetToolbar {
     bool button_save_project_pressed;
     bool button_export_png_pressed;
     bool button_export_bundle_pressed;
+    bool button_repack_pressed;
 } RSP_WidgetToolbar;
 
 // -----------------------------------------------------------------------------
@@ -145,7 +205,11 @@ typedef struct RSP_WidgetToolbar {
 static RSP_WidgetWelcome widget_welcome;
 static RSP_WidgetToolbar widget_toolbar;
 
-static RSP_Project current_project;
+// NOTE: One per thread so the command line can build several projects at once,
+// the editor only ever touches the main thread's
+static _Thread_local RSP_Project current_project;
+
+static int pack_threads_count = DEFAULT_PACK_THREADS;
 
 static RSP_Mode current_application_mode;
 
@@ -189,16 +253,34 @@ RSP_ProjectError RSP_SaveProject (void);
 RSP_ProjectError RSP_UnloadProject (void);
 
 // Editor
-static int CompareTextureSizes (const void* a, const void* b);
-
 static void LoadSprites (FilePathList files);
-static void SortSprites (void);
+static bool SortSprites (void);
+static bool InsertSprites (uint16_t first);
 static void RenderAtlas (void);
+static void RenderSprites (uint16_t first);
+
+static void UnloadPackers (void);
+static void ResolveAliases (void);
+static int32_t FindDuplicateSprite (RSP_Sprite* sprite, Image image);
+
+static void ResizeAtlasPages (uint16_t count);
+static void UnloadAtlasPage (uint16_t page);
+static void UploadAtlasPage (uint16_t page);
+static Rectangle GetSpriteBounds (RSP_Sprite* sprite);
+static Vector2 GetSpriteTrimSize (RSP_Sprite* sprite);
+static Vector2 SpriteToEditor (RSP_Sprite* sprite, Vector2 point);
+static Vector2 EditorToSprite (RSP_Sprite* sprite, Vector2 point);
+static void SetSpritePlacement (RSP_Sprite* sprite, RSP_PackRect rect);
+static void DrawSpriteToPage (RSP_Sprite* sprite);
 
 // Bundles
-static void RSP_ExportBundle (void);
+static bool RSP_ExportBundle (const char* directory);
 static void RSP_LoadBundle (void);
 
+// Command line
+static int RSP_RunBuild (int argc, const char* argv[]);
+static bool BuildProject (const char* project_file, const char* output_directory);
+
 // Utility
 void CopyFile (const char* source, const char* destination);
 void ShowAlert (const char* text);
@@ -207,6 +289,9 @@ void ShowAlert (const char* text);
 // Core Application
 // -----------------------------------------------------------------------------
 int main (int argc, const char* argv[]) {
+    if (argc > 1 && TextIsEqual (argv[1], "build"))
+        return RSP_RunBuild (argc - 2, argv + 2);
+
     InitWindow (MINIMUM_WINDOW_WIDTH, MINIMUM_WINDOW_HEIGHT, WINDOW_TITLE);
 
     { // :window settings
@@ -318,7 +403,8 @@ RSP_WidgetWelcome RSP_InitWelcome (void) {
     state.anchor = Vector2Zero ();
     state.active = true;
 
-    state.value_atlas_align = 16;
+    state.value_atlas_align     = 16;
+    state.dropdown_codec_active = DEFAULT_BUNDLE_CODEC;
 
     strncpy (state.textbox_project_name_text, "Hello World", 12);
 
@@ -418,9 +504,14 @@ void RSP_UpdateEditor (void) {
     if (IsFileDropped ()) {
         FilePathList files = LoadDroppedFiles ();
 
+        uint16_t first_new_sprite = current_project.sprites_count;
+
         LoadSprites (files);
-        SortSprites ();
-        RenderAtlas ();
+
+        if (InsertSprites (first_new_sprite))
+            RenderSprites (first_new_sprite);
+        else
+            RenderAtlas ();
 
         UnloadDroppedFiles (files);
     }
@@ -429,22 +520,32 @@ void RSP_UpdateEditor (void) {
         RSP_SaveProject ();
 
     if (widget_toolbar.button_export_png_pressed) {
-        const char* filename = TextFormat ("%s/%s/%s", DEFAULT_PROJECT_DIRECTORY, current_project.name, "atlas.png");
-
-        if (FileExists (filename))
-            remove (filename);
+        for (size_t i = 0; i < current_project.pages_count; i++) {
+            const char* filename = current_project.pages_count == 1
+                                       ? TextFormat ("%s/%s/%s", DEFAULT_PROJECT_DIRECTORY, current_project.name, "atlas.png")
+                                       : TextFormat ("%s/%s/atlas_%zu.png", DEFAULT_PROJECT_DIRECTORY, current_project.name, i);
 
-        Image atlas = LoadImageFromTexture (current_project.atlas.texture);
-        ImageFlipVertical (&atlas);
+            if (FileExists (filename))
+                remove (filename);
 
-        ExportImage (atlas, filename);
-        UnloadImage (atlas);
+            ExportImage (current_project.pages[i], filename);
+        }
 
         ShowAlert ("Atlas exported!");
     }
 
     if (widget_toolbar.button_export_bundle_pressed) {
-        RSP_ExportBundle ();
+        if (RSP_ExportBundle (TextFormat ("%s/%s", DEFAULT_PROJECT_DIRECTORY, current_project.name)))
+            ShowAlert ("Bundle exported!");
+        else
+            ShowAlert ("Could not write bundle!");
+    }
+
+    if (widget_toolbar.button_repack_pressed) {
+        if (SortSprites ())
+            RenderAtlas ();
+        else
+            ShowAlert ("A sprite is too large for the atlas!");
     }
 
     if (!EDITOR_STATE.show_sprite_name_editor) {
@@ -453,7 +554,7 @@ void RSP_UpdateEditor (void) {
         for (size_t i = 0; i < current_project.sprites_count; i++) {
             RSP_Sprite* sprite = &current_project.sprites[i];
 
-            if (CheckCollisionPointRec (EDITOR_STATE.mouse, sprite->source)) {
+            if (CheckCollisionPointRec (EDITOR_STATE.mouse, GetSpriteBounds (sprite))) {
                 EDITOR_STATE.current_hovered_sprite = sprite;
                 break;
             }
@@ -463,12 +564,8 @@ void RSP_UpdateEditor (void) {
     if (GetMousePosition ().y > 48) {
         if (EDITOR_STATE.current_hovered_sprite != NULL) {
             if (IsMouseButtonReleased (MOUSE_BUTTON_LEFT)) {
-                Vector2 origin_offset = CLITERAL (Vector2){
-                    EDITOR_STATE.current_hovered_sprite->source.x,
-                    EDITOR_STATE.current_hovered_sprite->source.y,
-                };
-
-                Vector2 new_origin = Vector2Subtract (EDITOR_STATE.mouse, origin_offset);
+                // NOTE: Origins are relative to the untrimmed, unrotated image
+                Vector2 new_origin = EditorToSprite (EDITOR_STATE.current_hovered_sprite, EDITOR_STATE.mouse);
 
                 EDITOR_STATE.current_hovered_sprite->origin = CLITERAL (Vector2){
                     roundf (new_origin.x),
@@ -484,7 +581,7 @@ void RSP_UpdateEditor (void) {
 }
 
 void RSP_RenderWelcome (void) {
-    if (widget_welcome.dropdown_atlas_size_edit)
+    if (widget_welcome.dropdown_atlas_size_edit || widget_welcome.dropdown_codec_edit)
         GuiLock ();
 
     if (widget_welcome.active) {
@@ -502,6 +599,10 @@ void RSP_RenderWelcome (void) {
             CLITERAL (Rectangle){widget_welcome.anchor.x + 16,  widget_welcome.anchor.y + 288, 128,                  24                   },
             CLITERAL (Rectangle){widget_welcome.anchor.x + 16,  widget_welcome.anchor.y + 256, 128,                  24                   },
             CLITERAL (Rectangle){widget_welcome.anchor.x + 152, widget_welcome.anchor.y + 256, 96,                   24                   },
+            CLITERAL (Rectangle){widget_welcome.anchor.x + 264, widget_welcome.anchor.y + 224, 24,                   24                   },
+            CLITERAL (Rectangle){widget_welcome.anchor.x + 264, widget_welcome.anchor.y + 256, 24,                   24                   },
+            CLITERAL (Rectangle){widget_welcome.anchor.x + 472, widget_welcome.anchor.y + 224, 152,                  24                   },
+            CLITERAL (Rectangle){widget_welcome.anchor.x + 472, widget_welcome.anchor.y + 256, 152,                  24                   },
         };
 
         // Temp for now
@@ -522,12 +623,20 @@ void RSP_RenderWelcome (void) {
                 TOGGLE (widget_welcome.textbox_project_name_edit);
 
             GuiLabel (layouts[8], "Atlas Size");
-            if (GuiDropdownBox (layouts[9], "512;1024;2048;4096;8192", &widget_welcome.dropdown_atlas_size_active, widget_welcome.dropdown_atlas_size_edit))
+            if (GuiDropdownBox (layouts[9], "Auto;512;1024;2048;4096;8192", &widget_welcome.dropdown_atlas_size_active, widget_welcome.dropdown_atlas_size_edit))
                 TOGGLE (widget_welcome.dropdown_atlas_size_edit);
 
             GuiLabel (layouts[11], "Alignment Value");
             if (GuiValueBox (layouts[10], NULL, &widget_welcome.value_atlas_align, 0, 128, widget_welcome.value_atlas_align_edit))
                 TOGGLE (widget_welcome.value_atlas_align_edit);
+
+            GuiCheckBox (layouts[12], "Allow Rotation", &widget_welcome.checkbox_allow_rotation_checked);
+            GuiCheckBox (layouts[13], "Non Square Atlas", &widget_welcome.checkbox_non_square_checked);
+
+            // NOTE: Same order as SpriteBundleCodec, drawn last so it opens over the button
+            GuiLabel (layouts[14], "Page Codec");
+            if (GuiDropdownBox (layouts[15], "PNG;LZ4;QOI;Raw", &widget_welcome.dropdown_codec_active, widget_welcome.dropdown_codec_edit))
+                TOGGLE (widget_welcome.dropdown_codec_edit);
         }
     }
 
@@ -548,33 +657,38 @@ static void __RSP_Toolbar (void) {
     GuiSetTooltip ("Export Bundle");
     widget_toolbar.button_export_bundle_pressed = GuiButton (CLITERAL (Rectangle){88, 8, 32, 32}, "#200#");
 
+    GuiSetTooltip ("Repack Atlas");
+    widget_toolbar.button_repack_pressed = GuiButton (CLITERAL (Rectangle){128, 8, 32, 32}, "#77#");
+
     GuiDisableTooltip ();
 }
 
 void RSP_RenderEditor (void) {
     BeginMode2D (camera);
 
-    DrawRectangleLines (-1, -1, current_project.atlas_size + 2, current_project.atlas_size + 2, RED);
-    DrawTexturePro (current_project.atlas.texture, CLITERAL (Rectangle){0, 0, current_project.atlas_size, -current_project.atlas_size}, CLITERAL (Rectangle){0, 0, current_project.atlas_size, current_project.atlas_size}, Vector2Zero (), 0.0f, WHITE);
+    for (size_t i = 0; i < current_project.pages_count; i++) {
+        const float offset = i * (current_project.atlas_width + ATLAS_PAGE_SPACING);
+
+        DrawRectangleLines (offset - 1, -1, current_project.atlas_width + 2, current_project.atlas_height + 2, RED);
+        DrawTextureV (current_project.page_previews[i], CLITERAL (Vector2){offset, 0}, WHITE);
+    }
 
     if (EDITOR_STATE.current_hovered_sprite != NULL) {
-        DrawRectangleLinesEx (EDITOR_STATE.current_hovered_sprite->source, 0.1, GREEN);
+        Rectangle bounds = GetSpriteBounds (EDITOR_STATE.current_hovered_sprite);
+
+        DrawRectangleLinesEx (bounds, 0.1, GREEN);
 
         DrawLineV (
-            CLITERAL (Vector2){.x = EDITOR_STATE.current_hovered_sprite->source.x, .y = EDITOR_STATE.mouse.y},
-            CLITERAL (Vector2){.x = EDITOR_STATE.current_hovered_sprite->source.x + EDITOR_STATE.current_hovered_sprite->source.width, .y = EDITOR_STATE.mouse.y},
+            CLITERAL (Vector2){.x = bounds.x, .y = EDITOR_STATE.mouse.y},
+            CLITERAL (Vector2){.x = bounds.x + bounds.width, .y = EDITOR_STATE.mouse.y},
             WHITE);
 
         DrawLineV (
-            CLITERAL (Vector2){.x = EDITOR_STATE.mouse.x, .y = EDITOR_STATE.current_hovered_sprite->source.y},
-            CLITERAL (Vector2){.x = EDITOR_STATE.mouse.x, .y = EDITOR_STATE.current_hovered_sprite->source.y + EDITOR_STATE.current_hovered_sprite->source.height},
+            CLITERAL (Vector2){.x = EDITOR_STATE.mouse.x, .y = bounds.y},
+            CLITERAL (Vector2){.x = EDITOR_STATE.mouse.x, .y = bounds.y + bounds.height},
             WHITE);
 
-        Vector2 origin = Vector2Add (
-            EDITOR_STATE.current_hovered_sprite->origin,
-            CLITERAL (Vector2){
-                EDITOR_STATE.current_hovered_sprite->source.x,
-                EDITOR_STATE.current_hovered_sprite->source.y});
+        Vector2 origin = SpriteToEditor (EDITOR_STATE.current_hovered_sprite, EDITOR_STATE.current_hovered_sprite->origin);
 
         DrawCircleV (origin, 1.0f, Fade (RED, 0.5f));
         DrawCircleLinesV (origin, 1.0f, RED);
@@ -606,14 +720,24 @@ RSP_ProjectError RSP_CreateAndLoadProject (const char* project_name) {
     MakeDirectory (project_directory);
     MakeDirectory (TextFormat ("%s/textures", project_directory));
 
-    const uint16_t atlas_sizes[5] = {512, 1024, 2048, 4096, 8192};
+    // NOTE: Auto sized projects may grow all the way up to the largest size
+    const uint16_t atlas_sizes[6] = {MAX_ATLAS_SIZE, 512, 1024, 2048, 4096, 8192};
 
     {
         current_project.version = DEFAULT_PROJECT_VERSION,
         strncpy (current_project.name, widget_welcome.textbox_project_name_text, MAX_PROJECT_NAME_LENGTH);
 
-        current_project.alignment  = widget_welcome.value_atlas_align;
-        current_project.atlas_size = atlas_sizes[widget_welcome.dropdown_atlas_size_active];
+        current_project.alignment      = widget_welcome.value_atlas_align;
+        current_project.atlas_size     = atlas_sizes[widget_welcome.dropdown_atlas_size_active];
+        current_project.allow_rotation = widget_welcome.checkbox_allow_rotation_checked;
+
+        current_project.auto_atlas_size  = widget_welcome.dropdown_atlas_size_active == 0;
+        current_project.allow_non_square = widget_welcome.checkbox_non_square_checked;
+
+        current_project.codec = (uint8_t)widget_welcome.dropdown_codec_active;
+
+        current_project.atlas_width  = current_project.auto_atlas_size ? MIN_ATLAS_SIZE : current_project.atlas_size;
+        current_project.atlas_height = current_project.atlas_width;
     }
 
     RSP_ProjectError status = RSP_SaveProject ();
@@ -645,9 +769,30 @@ RSP_ProjectError RSP_LoadProject (const char* project_file) {
     current_project.atlas_size = (uint16_t)json_object_get_number (root_object, "atlas_size");
     current_project.alignment  = (uint8_t)json_object_get_number (root_object, "alignment");
 
-    current_project.atlas = LoadRenderTexture (current_project.atlas_size, current_project.atlas_size);
+    // NOTE: Missing from older projects, parson returns -1 in that case
+    current_project.allow_rotation = json_object_get_boolean (root_object, "allow_rotation") == 1;
+
+    current_project.auto_atlas_size  = json_object_get_boolean (root_object, "auto_atlas_size") == 1;
+    current_project.allow_non_square = json_object_get_boolean (root_object, "allow_non_square") == 1;
+
+    // NOTE: Older projects were always exported as PNG, which parson's 0 for a
+    // missing number already gives
+    current_project.codec = (uint8_t)json_object_get_number (root_object, "codec");
+
+    // NOTE: Older projects only have the one fixed size
+    current_project.atlas_width  = json_object_has_value (root_object, "atlas_width") ? (uint16_t)json_object_get_number (root_object, "atlas_width") : current_project.atlas_size;
+    current_project.atlas_height = json_object_has_value (root_object, "atlas_height") ? (uint16_t)json_object_get_number (root_object, "atlas_height") : current_project.atlas_size;
+
+    JSON_Array* sprites_array = json_object_get_array (root_object, "sprites");
+
+    // NOTE: Sprite ids only have 16 bits for the index
+    if (json_array_get_count (sprites_array) > UINT16_MAX) {
+        TraceLog (LOG_ERROR, "Project has %zu sprites, at most %d are supported!", json_array_get_count (sprites_array), UINT16_MAX);
+        json_value_free (root);
+
+        return RSP_PROJECT_ERROR_FAILED_READ;
+    }
 
-    JSON_Array* sprites_array     = json_object_get_array (root_object, "sprites");
     current_project.sprites_count = (uint16_t)json_array_get_count (sprites_array);
 
     current_project.sprites = MemAlloc (sizeof (RSP_Sprite) * current_project.sprites_count);
@@ -662,6 +807,7 @@ RSP_ProjectError RSP_LoadProject (const char* project_file) {
         strncpy (sprite->file, json_object_get_string (sprite_object, "file"), MAX_ASSET_FILE_LENGTH);
 
         sprite->flags = (uint16_t)json_object_get_number (sprite_object, "flags");
+        sprite->page  = (uint16_t)json_object_get_number (sprite_object, "page");
 
         sprite->source = CLITERAL (Rectangle){
             (float)json_object_dotget_number (sprite_object, "source.x"),
@@ -675,14 +821,65 @@ RSP_ProjectError RSP_LoadProject (const char* project_file) {
             (float)json_object_dotget_number (sprite_object, "origin.y"),
         };
 
+        sprite->offset = CLITERAL (Vector2){
+            (float)json_object_dotget_number (sprite_object, "offset.x"),
+            (float)json_object_dotget_number (sprite_object, "offset.y"),
+        };
+
+        sprite->size = CLITERAL (Vector2){
+            (float)json_object_dotget_number (sprite_object, "size.width"),
+            (float)json_object_dotget_number (sprite_object, "size.height"),
+        };
+
+        // NOTE: Projects from before trimming have no size saved
+        if (sprite->size.x == 0 || sprite->size.y == 0)
+            sprite->size = CLITERAL (Vector2){sprite->source.width, sprite->source.height};
+
+        sprite->alias = json_object_has_value (sprite_object, "alias") ? (int32_t)json_object_get_number (sprite_object, "alias") : -1;
+
+        // NOTE: Duplicates always point back to an earlier sprite, anything
+        // else was edited by hand and would read outside the sprites
+        if (sprite->alias < -1 || sprite->alias >= (int32_t)i) {
+            TraceLog (LOG_ERROR, "Sprite %s has an invalid alias %d!", sprite->name, sprite->alias);
+
+            for (size_t j = 0; j < i; j++)
+                UnloadImage (current_project.sprites[j].image);
+
+            MemFree (current_project.sprites);
+
+            current_project.sprites       = NULL;
+            current_project.sprites_count = 0;
+
+            json_value_free (root);
+
+            return RSP_PROJECT_ERROR_FAILED_READ;
+        }
+
+        if (sprite->alias >= 0) {
+            sprite->hash = current_project.sprites[sprite->alias].hash;
+            continue;
+        }
+
         if (FileExists (sprite->file)) {
-            sprite->texture = LoadTexture (sprite->file);
+            Image image = LoadImage (sprite->file);
+            ImageFormat (&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+            Vector2 trim_size      = GetSpriteTrimSize (sprite);
+            RSP_PixelBounds bounds = CLITERAL (RSP_PixelBounds){sprite->offset.x, sprite->offset.y, trim_size.x, trim_size.y};
+
+            sprite->hash  = RSP_HashPixels (image.data, image.width, bounds);
+            sprite->image = image;
         } else
             TraceLog (LOG_ERROR, "Could not fine file %s!", sprite->file);
     }
 
     json_value_free (root);
 
+    uint16_t pages_count = 1;
+    for (size_t i = 0; i < current_project.sprites_count; i++)
+        pages_count = MAX (pages_count, current_project.sprites[i].page + 1);
+
+    ResizeAtlasPages (pages_count);
     RenderAtlas ();
 
     return RSP_PROJECT_ERROR_NONE;
@@ -714,7 +911,13 @@ RSP_ProjectError RSP_SaveProject (void) {
         json_object_set_string (root_object, "name", current_project.name);
         json_object_set_number (root_object, "version", current_project.version);
         json_object_set_number (root_object, "atlas_size", current_project.atlas_size);
+        json_object_set_number (root_object, "atlas_width", current_project.atlas_width);
+        json_object_set_number (root_object, "atlas_height", current_project.atlas_height);
+        json_object_set_boolean (root_object, "auto_atlas_size", current_project.auto_atlas_size);
+        json_object_set_boolean (root_object, "allow_non_square", current_project.allow_non_square);
         json_object_set_number (root_object, "alignment", current_project.alignment);
+        json_object_set_boolean (root_object, "allow_rotation", current_project.allow_rotation);
+        json_object_set_number (root_object, "codec", current_project.codec);
 
         json_object_set_boolean (root_object, "embed_files", current_project.should_embed_files);
 
@@ -731,6 +934,8 @@ RSP_ProjectError RSP_SaveProject (void) {
             json_object_set_string (sprite_object, "name", sprite->name);
             json_object_set_string (sprite_object, "file", sprite->file);
             json_object_set_number (sprite_object, "flags", (double)sprite->flags);
+            json_object_set_number (sprite_object, "page", (double)sprite->page);
+            json_object_set_number (sprite_object, "alias", (double)sprite->alias);
 
             // Sprite source
             json_object_dotset_number (sprite_object, "source.x", sprite->source.x);
@@ -742,6 +947,12 @@ RSP_ProjectError RSP_SaveProject (void) {
             json_object_dotset_number (sprite_object, "origin.x", sprite->origin.x);
             json_object_dotset_number (sprite_object, "origin.y", sprite->origin.y);
 
+            // Trimming
+            json_object_dotset_number (sprite_object, "offset.x", sprite->offset.x);
+            json_object_dotset_number (sprite_object, "offset.y", sprite->offset.y);
+            json_object_dotset_number (sprite_object, "size.width", sprite->size.x);
+            json_object_dotset_number (sprite_object, "size.height", sprite->size.y);
+
             // Animation
             json_object_dotset_number (sprite_object, "animation.speed", sprite->animation.frames_speed);
             json_object_dotset_number (sprite_object, "animation.frame_count", sprite->animation.frames_count);
@@ -777,7 +988,7 @@ RSP_ProjectError RSP_UnloadProject (void) {
     for (size_t i = 0; i < current_project.sprites_count; i++) {
         RSP_Sprite* sprite = &current_project.sprites[i];
 
-        UnloadTexture (sprite->texture);
+        UnloadImage (sprite->image);
 
         if (sprite->animation.frames_count > 0)
             MemFree (sprite->animation.frames);
@@ -785,6 +996,9 @@ RSP_ProjectError RSP_UnloadProject (void) {
 
     MemFree (current_project.sprites);
 
+    UnloadPackers ();
+    ResizeAtlasPages (0);
+
     UnloadDirectoryFiles (current_project.assets);
 
     current_project.assets.count  = 0;
@@ -796,39 +1010,6 @@ RSP_ProjectError RSP_UnloadProject (void) {
 // -----------------------------------------------------------------------------
 // Editor
 // -----------------------------------------------------------------------------
-static int CompareTextureSizes (const void* a, const void* b) {
-    RSP_Sprite* sprite_a = (RSP_Sprite*)a;
-    RSP_Sprite* sprite_b = (RSP_Sprite*)b;
-
-    int mass_a = (int)(sprite_a->source.width * sprite_a->source.height);
-    int mass_b = (int)(sprite_b->source.width * sprite_b->source.height);
-
-    if (mass_a == mass_b) {
-        if ((int)sprite_a->source.width == (int)sprite_b->source.width) {
-            if (sprite_a->source.height > sprite_b->source.height)
-                return -1;
-            if (sprite_b->source.height > sprite_a->source.height)
-                return 1;
-
-            return 0;
-        } else {
-            if (sprite_a->source.width > sprite_b->source.width)
-                return -1;
-            if (sprite_b->source.width > sprite_a->source.width)
-                return 1;
-
-            return 0;
-        }
-    } else {
-        if (mass_a > mass_b)
-            return -1;
-        if (mass_b > mass_a)
-            return 1;
-    }
-
-    return 0;
-}
-
 static bool __is_image (const char* filename) {
     const char* accepted_formats[] = {".png", ".bmp", ".tga", ".jpg", ".jpeg", ".gif", ".qoi", ".psd;", ".dds", ".hdr", ".ktx", ".astc", ".pkm", ".pvr"};
 
@@ -846,7 +1027,7 @@ void LoadSprites (FilePathList files) {
         return;
     }
 
-    uint16_t filtered_file_count = 0;
+    size_t filtered_file_count = 0;
     const char* filtered_files[files.count];
 
     for (size_t i = 0; i < files.count; i++) {
@@ -858,172 +1039,757 @@ void LoadSprites (FilePathList files) {
         }
     }
 
+    if (current_project.sprites_count + filtered_file_count > UINT16_MAX) {
+        TraceLog (LOG_ERROR, "Adding %zu sprites would go past %d sprites", filtered_file_count, UINT16_MAX);
+        ShowAlert ("Too many sprites! Aborting!");
+
+        return;
+    }
+
     current_project.sprites = MemRealloc (current_project.sprites, (current_project.sprites_count + filtered_file_count) * sizeof (RSP_Sprite));
 
     for (size_t i = 0; i < filtered_file_count; i++) {
-        const char* new_filename = TextFormat ("projects/%s/textures/%d%s", current_project.name, current_project.sprites_count, GetFileExtension (filtered_files[i]));
-        CopyFile (filtered_files[i], new_filename);
-
         current_project.sprites[current_project.sprites_count] = CLITERAL (RSP_Sprite){0};
         RSP_Sprite* sprite                                     = &current_project.sprites[current_project.sprites_count];
 
         strncpy (sprite->name, GetFileNameWithoutExt (filtered_files[i]), MAX_ASSET_NAME_LENGTH);
-        strncpy (sprite->file, new_filename, MAX_ASSET_FILE_LENGTH);
 
-        sprite->texture = LoadTexture (filtered_files[i]);
-        if (sprite->texture.width > current_project.atlas_size || sprite->texture.height > current_project.atlas_size) {
+        Image image = LoadImage (filtered_files[i]);
+        ImageFormat (&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+        // Only the opaque part is packed, the trimmed border is kept as an offset
+        RSP_PixelBounds bounds = RSP_GetOpaqueBounds (image.data, image.width, image.height);
+
+        if (bounds.width > current_project.atlas_size || bounds.height > current_project.atlas_size) {
             ShowAlert (TextFormat ("Texture [%s] too large! Aborting!", sprite->name));
 
-            UnloadTexture (sprite->texture);
-            remove (new_filename);
+            UnloadImage (image);
 
             break;
         }
 
-        sprite->source = CLITERAL (Rectangle){0, 0, sprite->texture.width, sprite->texture.height};
+        sprite->source = CLITERAL (Rectangle){0, 0, bounds.width, bounds.height};
         sprite->origin = CLITERAL (Vector2){0};
+        sprite->offset = CLITERAL (Vector2){bounds.x, bounds.y};
+        sprite->size   = CLITERAL (Vector2){image.width, image.height};
+
+        sprite->hash  = RSP_HashPixels (image.data, image.width, bounds);
+        sprite->alias = FindDuplicateSprite (sprite, image);
+
+        if (sprite->alias < 0) {
+            const char* new_filename = TextFormat ("projects/%s/textures/%d%s", current_project.name, current_project.sprites_count, GetFileExtension (filtered_files[i]));
+            CopyFile (filtered_files[i], new_filename);
+
+            strncpy (sprite->file, new_filename, MAX_ASSET_FILE_LENGTH);
+
+            sprite->image = image;
+        } else {
+            // Nothing to copy or pack, the original's pixels get reused
+            strncpy (sprite->file, current_project.sprites[sprite->alias].file, MAX_ASSET_FILE_LENGTH);
+
+            UnloadImage (image);
+        }
 
         current_project.sprites_count++;
     }
 }
 
-void SortSprites (void) {
-    qsort (current_project.sprites, current_project.sprites_count, sizeof (RSP_Sprite), CompareTextureSizes);
-    Rectangle atlas_bounds = CLITERAL (Rectangle){0, 0, current_project.atlas_size, current_project.atlas_size};
+// NOTE: Returns false and leaves the layout as it was when a sprite is larger
+// than the largest page allowed
+bool SortSprites (void) {
+    RSP_PackRect* rects = MemAlloc (sizeof (RSP_PackRect) * current_project.sprites_count);
+    uint16_t count      = 0;
 
-    int textures_placed = 0;
     for (size_t i = 0; i < current_project.sprites_count; i++) {
-        Rectangle* current_rectangle = &current_project.sprites[i].source;
+        RSP_Sprite* sprite = &current_project.sprites[i];
 
-        for (size_t j = 0; j < textures_placed; j++) {
-            while (CheckCollisionRecs (*current_rectangle, current_project.sprites[j].source)) {
-                current_rectangle->x += current_project.sprites[j].source.width;
+        if (sprite->alias >= 0)
+            continue;
 
-                int within_x = (current_rectangle->x + current_rectangle->width) <= current_project.atlas_size;
+        Vector2 trim_size = GetSpriteTrimSize (sprite);
 
-                if (!within_x) {
-                    current_rectangle->x = 0;
-                    current_rectangle->y += current_project.alignment;
+        rects[count++] = CLITERAL (RSP_PackRect){
+            .id     = i,
+            .width  = (int)trim_size.x,
+            .height = (int)trim_size.y,
+        };
+    }
 
-                    j = 0;
-                }
-            }
+    RSP_PackOptions options = CLITERAL (RSP_PackOptions){
+        .width          = current_project.atlas_size,
+        .height         = current_project.atlas_size,
+        .alignment      = current_project.alignment,
+        .allow_rotation = current_project.allow_rotation,
+    };
+
+    int pages_count = current_project.auto_atlas_size
+                          ? RSP_PackRectsSmallest (rects, count, &options, !current_project.allow_non_square, pack_threads_count)
+                          : RSP_PackRectsBest (rects, count, &options, pack_threads_count);
+
+    if (pages_count < 0) {
+        TraceLog (LOG_ERROR, "PACKER: A sprite is larger than a %dx%d page, layout left as it was", options.width, options.height);
+        MemFree (rects);
+
+        return false;
+    }
+
+    TraceLog (LOG_INFO, "PACKER: %d sprites on %d %dx%d pages [sort %d, method %d, heuristic %d]", count, pages_count, options.width, options.height, options.sort, options.method, options.heuristic);
+
+    // NOTE: Never below the minimum so an emptied project still has a page to show
+    current_project.atlas_width  = MAX (options.width, MIN_ATLAS_SIZE);
+    current_project.atlas_height = MAX (options.height, MIN_ATLAS_SIZE);
+
+    for (size_t i = 0; i < count; i++)
+        SetSpritePlacement (&current_project.sprites[rects[i].id], rects[i]);
+
+    MemFree (rects);
+
+    ResolveAliases ();
+
+    // NOTE: Layout changed completely, packers get rebuilt on the next insert
+    UnloadPackers ();
+    ResizeAtlasPages (MAX (pages_count, 1));
+
+    return true;
+}
+
+// Forgets sprites from first onwards, for ones that were loaded but could
+// never be placed
+static void DropSprites (uint16_t first) {
+    for (size_t i = first; i < current_project.sprites_count; i++) {
+        RSP_Sprite* sprite = &current_project.sprites[i];
+
+        UnloadImage (sprite->image);
+
+        if (sprite->animation.frames_count > 0)
+            MemFree (sprite->animation.frames);
+    }
+
+    current_project.sprites_count = first;
+}
+
+// NOTE: Only packs sprites from first onwards into the space left over,
+// anything already placed keeps its source rectangle. Auto sized projects that
+// run out of room are repacked at a larger size instead, returns false when
+// that happened and the whole atlas needs redrawing
+bool InsertSprites (uint16_t first) {
+    if (first >= current_project.sprites_count)
+        return true;
+
+    RSP_PackOptions options = CLITERAL (RSP_PackOptions){
+        .width          = current_project.atlas_width,
+        .height         = current_project.atlas_height,
+        .alignment      = current_project.alignment,
+        .allow_rotation = current_project.allow_rotation,
+        .method         = RSP_PACK_MAXRECTS,
+        .heuristic      = DEFAULT_INSERT_HEURISTIC,
+    };
+
+    if (current_project.packers == NULL) {
+        // NOTE: Plain calloc as the packer grows this array with realloc
+        current_project.packers = calloc (current_project.pages_count, sizeof (RSP_Packer));
+
+        for (size_t i = 0; i < current_project.pages_count; i++)
+            current_project.packers[i] = RSP_InitPacker (options);
+
+        for (size_t i = 0; i < first; i++) {
+            RSP_Sprite* sprite = &current_project.sprites[i];
+
+            if (sprite->alias >= 0)
+                continue;
+
+            RSP_PackRect rect = CLITERAL (RSP_PackRect){
+                .x      = (int)sprite->source.x,
+                .y      = (int)sprite->source.y,
+                .width  = (int)sprite->source.width,
+                .height = (int)sprite->source.height,
+            };
+
+            RSP_PackerOccupy (&current_project.packers[sprite->page], rect);
         }
+    }
 
-        bool inside_top_left     = (current_rectangle->x >= atlas_bounds.x && current_rectangle->y >= atlas_bounds.y);
-        bool inside_bottom_right = ((current_rectangle->x + current_rectangle->width) <= (atlas_bounds.x + atlas_bounds.width) &&
-                                    (current_rectangle->y + current_rectangle->height) <= (atlas_bounds.y + atlas_bounds.height));
+    RSP_PackRect* rects = MemAlloc (sizeof (RSP_PackRect) * (current_project.sprites_count - first));
+    uint16_t count      = 0;
 
-        if (!inside_top_left || !inside_bottom_right) {
-            for (size_t k = textures_placed; k < current_project.sprites_count; k++) {
-                RSP_Sprite* sprite = &current_project.sprites[k];
+    for (size_t i = first; i < current_project.sprites_count; i++) {
+        RSP_Sprite* sprite = &current_project.sprites[i];
 
-                UnloadTexture (sprite->texture);
+        if (sprite->alias >= 0)
+            continue;
 
-                if (sprite->animation.frames_count > 0)
-                    MemFree (sprite->animation.frames);
-            }
+        Vector2 trim_size = GetSpriteTrimSize (sprite);
 
-            current_project.sprites_count = textures_placed;
+        rects[count++] = CLITERAL (RSP_PackRect){
+            .id     = i,
+            .width  = (int)trim_size.x,
+            .height = (int)trim_size.y,
+        };
+    }
 
-            break;
+    int pages_count = RSP_PackRectsInto (&current_project.packers, current_project.pages_count, rects, count, options);
+
+    if (current_project.auto_atlas_size && (current_project.atlas_width < current_project.atlas_size || current_project.atlas_height < current_project.atlas_size)) {
+        bool outgrown = pages_count < 0 || pages_count > current_project.pages_count;
+
+        if (outgrown) {
+            // NOTE: Pages the insert opened are dropped here, the rest go with the repack
+            for (int i = current_project.pages_count; i < pages_count; i++)
+                RSP_UnloadPacker (current_project.packers[i]);
+
+            MemFree (rects);
+
+            if (!SortSprites ()) {
+                DropSprites (first);
+                SortSprites ();
+            }
+
+            return false;
         }
+    }
+
+    // NOTE: Nothing was packed, the new sprites are too large for a page
+    if (pages_count < 0) {
+        TraceLog (LOG_ERROR, "PACKER: New sprites are larger than a %dx%d page, dropping them", options.width, options.height);
+
+        MemFree (rects);
+        DropSprites (first);
 
-        textures_placed++;
+        return true;
     }
-}
 
-void RenderAtlas (void) {
-    BeginTextureMode (current_project.atlas);
-    ClearBackground (Fade (BLACK, 0));
+    for (size_t i = 0; i < count; i++)
+        SetSpritePlacement (&current_project.sprites[rects[i].id], rects[i]);
 
+    MemFree (rects);
+
+    ResolveAliases ();
+    ResizeAtlasPages (pages_count);
+
+    return true;
+}
+
+// Duplicates take over wherever their original was packed
+void ResolveAliases (void) {
     for (size_t i = 0; i < current_project.sprites_count; i++) {
         RSP_Sprite* sprite = &current_project.sprites[i];
 
-        DrawTextureV (sprite->texture, CLITERAL (Vector2){sprite->source.x, sprite->source.y}, WHITE);
+        if (sprite->alias < 0)
+            continue;
+
+        RSP_Sprite* original = &current_project.sprites[sprite->alias];
+
+        sprite->source = original->source;
+        sprite->page   = original->page;
+
+        sprite->flags = (sprite->flags & ~RSP_SPRITE_ROTATED) | (original->flags & RSP_SPRITE_ROTATED);
     }
-    EndTextureMode ();
 }
 
-// -----------------------------------------------------------------------------
-// Bundles
-// -----------------------------------------------------------------------------
-void RSP_ExportBundle (void) {
-    const char* file = TextFormat ("%s/%s/bundle%s", DEFAULT_PROJECT_DIRECTORY, current_project.name, DEFAULT_BUNDLE_EXTENSION);
+// NOTE: Rects are packed by their trimmed size, the page rect is swapped when
+// the packer decided to rotate
+void SetSpritePlacement (RSP_Sprite* sprite, RSP_PackRect rect) {
+    Vector2 trim_size = GetSpriteTrimSize (sprite);
 
-    FILE* output = fopen (file, "wb");
+    if (rect.rotated) {
+        sprite->source = CLITERAL (Rectangle){rect.x, rect.y, trim_size.y, trim_size.x};
+        sprite->flags |= RSP_SPRITE_ROTATED;
+    } else {
+        sprite->source = CLITERAL (Rectangle){rect.x, rect.y, trim_size.x, trim_size.y};
+        sprite->flags &= ~RSP_SPRITE_ROTATED;
+    }
 
-    int32_t atlas_data_raw_size, atlas_data_compressed_size;
+    sprite->page = rect.page;
+}
 
-    Image atlas_image = LoadImageFromTexture (current_project.atlas.texture);
-    ImageFlipVertical (&atlas_image);
+// NOTE: The hash only narrows things down, pixels are compared before two
+// sprites are treated as the same
+int32_t FindDuplicateSprite (RSP_Sprite* sprite, Image image) {
+    Vector2 trim_size      = GetSpriteTrimSize (sprite);
+    RSP_PixelBounds bounds = CLITERAL (RSP_PixelBounds){sprite->offset.x, sprite->offset.y, trim_size.x, trim_size.y};
 
-    unsigned char* image_data_raw        = ExportImageToMemory (atlas_image, ".png", &atlas_data_raw_size);
-    unsigned char* image_data_compressed = CompressData (image_data_raw, atlas_data_raw_size, &atlas_data_compressed_size);
+    for (size_t i = 0; i < current_project.sprites_count; i++) {
+        RSP_Sprite* other = &current_project.sprites[i];
 
-    MemFree (image_data_raw);
-    UnloadImage (atlas_image);
+        if (other->alias >= 0 || other->hash != sprite->hash)
+            continue;
 
-    const char* file_type = "RSPX";
+        Vector2 other_size = GetSpriteTrimSize (other);
 
-    fwrite (file_type, sizeof (char), 4, output);
+        if (other_size.x != trim_size.x || other_size.y != trim_size.y)
+            continue;
 
-    fwrite (&current_project.sprites_count, sizeof (uint16_t), 1, output);
-    fwrite (&atlas_data_compressed_size, sizeof (int32_t), 1, output);
-    fwrite (image_data_compressed, sizeof (unsigned char), atlas_data_compressed_size, output);
+        RSP_PixelBounds other_bounds = CLITERAL (RSP_PixelBounds){other->offset.x, other->offset.y, other_size.x, other_size.y};
 
-    for (size_t i = 0; i < current_project.sprites_count; i++) {
-        RSP_Sprite* sprite = &current_project.sprites[i];
+        if (RSP_ComparePixels (image.data, image.width, bounds, other->image.data, other->image.width, other_bounds))
+            return i;
+    }
 
-        // Small header
-        fwrite ("SPR", sizeof (char), 4, output);
+    return -1;
+}
 
-        fwrite (sprite->name, sizeof (char), MAX_ASSET_NAME_LENGTH, output);
-        fwrite (&sprite->flags, sizeof (uint16_t), 1, output);
+void RenderAtlas (void) {
+    for (size_t i = 0; i < current_project.pages_count; i++) {
+        Image* page = &current_project.pages[i];
+        memset (page->data, 0, (size_t)page->width * page->height * 4);
 
-        fwrite (&sprite->origin.x, sizeof (float), 1, output);
-        fwrite (&sprite->origin.y, sizeof (float), 1, output);
+        for (size_t j = 0; j < current_project.sprites_count; j++) {
+            RSP_Sprite* sprite = &current_project.sprites[j];
 
-        fwrite (&sprite->source.x, sizeof (float), 1, output);
-        fwrite (&sprite->source.y, sizeof (float), 1, output);
-        fwrite (&sprite->source.width, sizeof (float), 1, output);
-        fwrite (&sprite->source.height, sizeof (float), 1, output);
+            if (sprite->page == i)
+                DrawSpriteToPage (sprite);
+        }
 
-        if (sprite->flags & RSP_SPRITE_ANIMATED) {
-            fwrite (&sprite->animation.frames_count, sizeof (uint16_t), 1, output);
-            fwrite (&sprite->animation.frames_speed, sizeof (uint16_t), 1, output);
+        UploadAtlasPage (i);
+    }
+}
 
-            for (size_t j = 0; j < sprite->animation.frames_count; j++) {
-                fwrite (&sprite->animation.frames[i].x, sizeof (float), 1, output);
-                fwrite (&sprite->animation.frames[i].y, sizeof (float), 1, output);
-                fwrite (&sprite->animation.frames[i].width, sizeof (float), 1, output);
-                fwrite (&sprite->animation.frames[i].height, sizeof (float), 1, output);
-            }
+// Draws sprites from first onwards over the current pages without clearing
+void RenderSprites (uint16_t first) {
+    for (size_t i = 0; i < current_project.pages_count; i++) {
+        bool page_changed = false;
+
+        for (size_t j = first; j < current_project.sprites_count; j++) {
+            RSP_Sprite* sprite = &current_project.sprites[j];
+
+            if (sprite->page != i)
+                continue;
+
+            DrawSpriteToPage (sprite);
+            page_changed = true;
         }
+
+        if (page_changed)
+            UploadAtlasPage (i);
     }
+}
 
-    MemFree (image_data_compressed);
+void UnloadPackers (void) {
+    if (current_project.packers == NULL)
+        return;
 
-    fclose (output);
+    for (size_t i = 0; i < current_project.pages_count; i++)
+        RSP_UnloadPacker (current_project.packers[i]);
+
+    free (current_project.packers);
+    current_project.packers = NULL;
+}
+
+// NOTE: Only reallocates when the page count or size changes, existing pages
+// are kept and new pages start cleared
+void ResizeAtlasPages (uint16_t count) {
+    // NOTE: Pages all share one size, so a resized atlas starts over
+    if (current_project.pages_count > 0) {
+        Image page = current_project.pages[0];
+
+        if (page.width != current_project.atlas_width || page.height != current_project.atlas_height) {
+            for (size_t i = 0; i < current_project.pages_count; i++)
+                UnloadAtlasPage (i);
+
+            current_project.pages_count = 0;
+        }
+    }
+
+    if (count == current_project.pages_count)
+        return;
+
+    for (size_t i = count; i < current_project.pages_count; i++)
+        UnloadAtlasPage (i);
+
+    if (count == 0) {
+        MemFree (current_project.pages);
+        MemFree (current_project.page_previews);
+
+        current_project.pages         = NULL;
+        current_project.page_previews = NULL;
+        current_project.pages_count   = 0;
 
-    const char* header = TextFormat ("%s/%s/bundle%s", DEFAULT_PROJECT_DIRECTORY, current_project.name, ".h");
+        return;
+    }
+
+    current_project.pages         = MemRealloc (current_project.pages, sizeof (Image) * count);
+    current_project.page_previews = MemRealloc (current_project.page_previews, sizeof (Texture2D) * count);
+
+    for (size_t i = current_project.pages_count; i < count; i++) {
+        current_project.pages[i]         = GenImageColor (current_project.atlas_width, current_project.atlas_height, BLANK);
+        current_project.page_previews[i] = CLITERAL (Texture2D){0};
+
+        // NOTE: Headless builds have no context to upload to, the pages alone
+        // are enough to export
+        if (IsWindowReady ())
+            current_project.page_previews[i] = LoadTextureFromImage (current_project.pages[i]);
+    }
+
+    current_project.pages_count = count;
+}
+
+void UnloadAtlasPage (uint16_t page) {
+    UnloadImage (current_project.pages[page]);
+
+    if (current_project.page_previews[page].id > 0)
+        UnloadTexture (current_project.page_previews[page]);
+}
+
+void UploadAtlasPage (uint16_t page) {
+    if (current_project.page_previews[page].id > 0)
+        UpdateTexture (current_project.page_previews[page], current_project.pages[page].data);
+}
+
+// NOTE: Copies straight into the page, sprites never overlap so there is
+// nothing to blend with
+void DrawSpriteToPage (RSP_Sprite* sprite) {
+    if (sprite->alias >= 0 || sprite->image.data == NULL)
+        return;
+
+    Vector2 trim_size      = GetSpriteTrimSize (sprite);
+    RSP_PixelBounds bounds = CLITERAL (RSP_PixelBounds){sprite->offset.x, sprite->offset.y, trim_size.x, trim_size.y};
+
+    Image* page = &current_project.pages[sprite->page];
+
+    RSP_BlitPixels (page->data, page->width, sprite->source.x, sprite->source.y, sprite->image.data, sprite->image.width, bounds, sprite->flags & RSP_SPRITE_ROTATED);
+}
+
+// Sprite rectangle in editor space, pages are laid out left to right
+Rectangle GetSpriteBounds (RSP_Sprite* sprite) {
+    Rectangle bounds = sprite->source;
+    bounds.x += sprite->page * (current_project.atlas_width + ATLAS_PAGE_SPACING);
+
+    return bounds;
+}
+
+Vector2 GetSpriteTrimSize (RSP_Sprite* sprite) {
+    if (sprite->flags & RSP_SPRITE_ROTATED)
+        return CLITERAL (Vector2){sprite->source.height, sprite->source.width};
+
+    return CLITERAL (Vector2){sprite->source.width, sprite->source.height};
+}
+
+// Maps a point on the untrimmed image into editor space, rotated sprites are
+// stored turned clockwise
+Vector2 SpriteToEditor (RSP_Sprite* sprite, Vector2 point) {
+    Rectangle bounds = GetSpriteBounds (sprite);
+    Vector2 local    = Vector2Subtract (point, sprite->offset);
+
+    if (sprite->flags & RSP_SPRITE_ROTATED)
+        local = CLITERAL (Vector2){bounds.width - local.y, local.x};
+
+    return Vector2Add (local, CLITERAL (Vector2){bounds.x, bounds.y});
+}
+
+Vector2 EditorToSprite (RSP_Sprite* sprite, Vector2 point) {
+    Rectangle bounds = GetSpriteBounds (sprite);
+    Vector2 local    = Vector2Subtract (point, CLITERAL (Vector2){bounds.x, bounds.y});
+
+    if (sprite->flags & RSP_SPRITE_ROTATED)
+        local = CLITERAL (Vector2){local.y, bounds.width - local.x};
+
+    return Vector2Add (local, sprite->offset);
+}
+
+// -----------------------------------------------------------------------------
+// Bundles
+// -----------------------------------------------------------------------------
+// NOTE: Has to match rsp__hash, the runtime looks sprites up by it
+static uint64_t __hash_name (const char* name) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (const char* p = name; *p; p++) {
+        hash ^= (uint64_t)(unsigned char)(*p);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// Pads with zeros up to the next multiple of alignment
+static void __write_padding (FILE* output, long alignment) {
+    long position = ftell (output);
+
+    for (long i = position; i % alignment != 0; i++)
+        fputc (0, output);
+}
+
+// Encodes a page with the project's codec, the result is freed with MemFree
+static unsigned char* __encode_page (Image page, int* size) {
+    const size_t pixels_size = (size_t)page.width * page.height * 4;
+    unsigned char* payload   = NULL;
+    size_t payload_size      = 0;
+
+    *size = 0;
+
+    switch (current_project.codec) {
+        case BUNDLE_CODEC_PNG:
+            return ExportImageToMemory (page, ".png", size);
+
+        case BUNDLE_CODEC_LZ4:
+            payload      = MemAlloc (RSP_GetLZ4Bound (pixels_size));
+            payload_size = RSP_EncodeLZ4 (page.data, pixels_size, payload, RSP_GetLZ4Bound (pixels_size));
+            break;
+
+        case BUNDLE_CODEC_QOI:
+            payload      = MemAlloc (RSP_GetQOIBound (page.width, page.height));
+            payload_size = RSP_EncodeQOI (page.data, page.width, page.height, payload, RSP_GetQOIBound (page.width, page.height));
+            break;
+
+        case BUNDLE_CODEC_RAW:
+            payload      = MemAlloc (pixels_size);
+            payload_size = pixels_size;
+
+            memcpy (payload, page.data, pixels_size);
+            break;
+
+        default:
+            return NULL;
+    }
+
+    if (payload_size == 0) {
+        MemFree (payload);
+        return NULL;
+    }
+
+    *size = (int)payload_size;
+
+    return payload;
+}
+
+// NOTE: Writes bundle.h, the enum & lookups work in plain C or C++14 where
+// they are constexpr. The sprite table needs the types from rsp.h so it only
+// shows up when that was included first.
+static bool __export_header (const char* directory, const Sprite* sprites, size_t sprites_count) {
+    char header[MAX_FILE_PATH_LENGTH];
+    snprintf (header, sizeof (header), "%s/bundle%s", directory, ".h");
 
     FILE* header_output = fopen (header, "w");
+    if (header_output == NULL)
+        return false;
 
     fprintf (header_output, "#ifndef RSP_SPRITE_NAMES\n");
     fprintf (header_output, "#define RSP_SPRITE_NAMES\n");
+    fprintf (header_output, "\n#include <stdint.h>\n");
+    fprintf (header_output, "\n#define RSP_SPRITE_COUNT %zu\n", sprites_count);
+    fprintf (header_output, "#define RSP_PAGE_COUNT %d\n", current_project.pages_count);
     fprintf (header_output, "\ntypedef enum RSP_SpriteName {\n");
 
-    for (size_t i = 0; i < current_project.sprites_count; i++) {
-        fprintf (header_output, "\tSPRITE_%s = %zu,\n", TextToUpper (current_project.sprites[i].name), i);
+    for (size_t i = 0; i < sprites_count; i++) {
+        char name[MAX_ASSET_NAME_LENGTH];
+
+        for (size_t j = 0; j < MAX_ASSET_NAME_LENGTH; j++)
+            name[j] = (char)toupper ((unsigned char)current_project.sprites[i].name[j]);
+
+        name[MAX_ASSET_NAME_LENGTH - 1] = '\0';
+
+        fprintf (header_output, "\tSPRITE_%s = %zu,\n", name, i);
     }
 
     fprintf (header_output, "} RSP_SpriteName;\n");
+
+    if (current_project.pages_count > 0) {
+        fprintf (header_output, "\n// Page sizes in pixels, divide a source rect by these for UVs\n");
+        fprintf (header_output, "static const uint16_t RSP_PAGE_SIZES[RSP_PAGE_COUNT][2] = {\n");
+
+        for (size_t i = 0; i < current_project.pages_count; i++)
+            fprintf (header_output, "\t{%d, %d},\n", current_project.pages[i].width, current_project.pages[i].height);
+
+        fprintf (header_output, "};\n");
+    }
+
+    fprintf (header_output, "\n#ifdef __cplusplus\n#define RSP_BAKED constexpr\n#else\n#define RSP_BAKED static inline\n#endif\n");
+
+    fprintf (header_output, "\n// Same FNV-1a hash rsp.h keeps with each sprite\n");
+    fprintf (header_output, "RSP_BAKED uint64_t RSP_HashSpriteNameFrom (const char* name, uint64_t hash) {\n");
+    fprintf (header_output, "\treturn *name ? RSP_HashSpriteNameFrom (name + 1, (hash ^ (unsigned char)*name) * 1099511628211ULL) : hash;\n");
+    fprintf (header_output, "}\n");
+    fprintf (header_output, "\nRSP_BAKED uint64_t RSP_HashSpriteName (const char* name) {\n");
+    fprintf (header_output, "\treturn RSP_HashSpriteNameFrom (name, 14695981039346656037ULL);\n");
+    fprintf (header_output, "}\n");
+
+    fprintf (header_output, "\nRSP_BAKED int RSP_GetSpriteIdFromHash (uint64_t hash) {\n");
+    fprintf (header_output, "\tswitch (hash) {\n");
+
+    for (size_t i = 0; i < sprites_count; i++) {
+        // NOTE: Repeated names resolve to the first sprite, same as GetSpriteId
+        bool repeated = false;
+
+        for (size_t j = 0; j < i && !repeated; j++)
+            repeated = sprites[j].hash == sprites[i].hash;
+
+        if (!repeated)
+            fprintf (header_output, "\t\tcase 0x%016llxULL: return %zu;\n", (unsigned long long)sprites[i].hash, i);
+    }
+
+    fprintf (header_output, "\t\tdefault: return -1;\n");
+    fprintf (header_output, "\t}\n");
+    fprintf (header_output, "}\n");
+
+    fprintf (header_output, "\nRSP_BAKED int RSP_GetSpriteIdFromName (const char* name) {\n");
+    fprintf (header_output, "\treturn RSP_GetSpriteIdFromHash (RSP_HashSpriteName (name));\n");
+    fprintf (header_output, "}\n");
+
+    fprintf (header_output, "\n#undef RSP_BAKED\n");
+
+    if (sprites_count > 0) {
+        fprintf (header_output, "\n#ifdef RSP_H\n");
+        fprintf (header_output, "// LoadBundleBaked (\"bundle%s\", RSP_SPRITES, RSP_SPRITE_COUNT) skips reading these from the bundle\n", DEFAULT_BUNDLE_EXTENSION);
+        fprintf (header_output, "static const Sprite RSP_SPRITES[RSP_SPRITE_COUNT] = {\n");
+
+        for (size_t i = 0; i < sprites_count; i++) {
+            const Sprite* sprite = &sprites[i];
+
+            fprintf (header_output, "\t{0x%016llxULL, \"", (unsigned long long)sprite->hash);
+
+            for (const char* c = sprite->name; *c; c++)
+                fprintf (header_output, (*c == '"' || *c == '\\') ? "\\%c" : "%c", *c);
+
+            fprintf (header_output, "\", %u, %u, {%.9g, %.9g, %.9g, %.9g}, {%.9g, %.9g}, {%.9g, %.9g}, {%.9g, %.9g}, {%u, %u, %u}, 0},\n",
+                     sprite->flags, sprite->page,
+                     sprite->source.x, sprite->source.y, sprite->source.width, sprite->source.height,
+                     sprite->origin.x, sprite->origin.y,
+                     sprite->offset.x, sprite->offset.y,
+                     sprite->size.x, sprite->size.y,
+                     sprite->animation.frames_index, sprite->animation.frames_count, sprite->animation.frames_speed);
+        }
+
+        fprintf (header_output, "};\n");
+        fprintf (header_output, "#endif // RSP_H\n");
+    }
+
     fprintf (header_output, "\n#endif // RSP_SPRITE_NAMES\n");
 
     fclose (header_output);
 
-    ShowAlert ("Bundle exported!");
+    return true;
+}
+
+// NOTE: Writes a v2 bundle, the sprite & frame tables are laid out exactly as
+// rsp.h uses them in memory. Written as is, so only little endian hosts
+// produce valid bundles. Sticks to snprintf over TextFormat, the command line
+// exports from several threads at once.
+bool RSP_ExportBundle (const char* directory) {
+    char file[MAX_FILE_PATH_LENGTH];
+    snprintf (file, sizeof (file), "%s/bundle%s", directory, DEFAULT_BUNDLE_EXTENSION);
+
+    FILE* output = fopen (file, "wb");
+    if (output == NULL)
+        return false;
+
+    uint32_t frames_count = 0;
+
+    for (size_t i = 0; i < current_project.sprites_count; i++) {
+        if (current_project.sprites[i].flags & RSP_SPRITE_ANIMATED)
+            frames_count += current_project.sprites[i].animation.frames_count;
+    }
+
+    Sprite* sprites   = MemAlloc (sizeof (Sprite) * MAX (current_project.sprites_count, 1));
+    Rectangle* frames = MemAlloc (sizeof (Rectangle) * MAX (frames_count, 1));
+
+    frames_count = 0;
+
+    for (size_t i = 0; i < current_project.sprites_count; i++) {
+        RSP_Sprite* sprite = &current_project.sprites[i];
+        Sprite* record     = &sprites[i];
+
+        memcpy (record->name, sprite->name, sizeof (record->name));
+        record->name[sizeof (record->name) - 1] = '\0';
+
+        record->hash   = __hash_name (record->name);
+        record->flags  = sprite->flags;
+        record->page   = sprite->page;
+        record->source = sprite->source;
+        record->origin = sprite->origin;
+        record->offset = sprite->offset;
+        record->size   = sprite->size;
+
+        if (sprite->flags & RSP_SPRITE_ANIMATED) {
+            record->animation.frames_index = frames_count;
+            record->animation.frames_count = sprite->animation.frames_count;
+            record->animation.frames_speed = sprite->animation.frames_speed;
+
+            for (size_t j = 0; j < sprite->animation.frames_count; j++)
+                frames[frames_count++] = sprite->animation.frames[j];
+        }
+    }
+
+    SpriteBundleSection sections[] = {
+        {{'S', 'P', 'R', 'T'}, current_project.sprites_count, 0, sizeof (Sprite) * current_project.sprites_count},
+        {{'F', 'R', 'M', 'S'}, frames_count, 0, sizeof (Rectangle) * frames_count},
+        {{'P', 'A', 'G', 'E'}, current_project.pages_count, 0, sizeof (SpriteBundlePage) * current_project.pages_count},
+    };
+
+    // NOTE: Everything is placed up front so the directory can be written first,
+    // tables & payloads start on 16 byte boundaries
+    uint64_t offset = sizeof (SpriteBundleHeader) + sizeof (sections);
+
+    for (size_t i = 0; i < lengthof (sections); i++) {
+        offset             = (offset + 15) & ~15ULL;
+        sections[i].offset = offset;
+        offset += sections[i].size;
+    }
+
+    SpriteBundlePage* pages  = MemAlloc (sizeof (SpriteBundlePage) * current_project.pages_count);
+    unsigned char** payloads = MemAlloc (sizeof (unsigned char*) * current_project.pages_count);
+    bool encoded             = true;
+
+    for (size_t i = 0; i < current_project.pages_count; i++) {
+        int payload_size = 0;
+        payloads[i]      = __encode_page (current_project.pages[i], &payload_size);
+
+        if (payloads[i] == NULL)
+            encoded = false;
+
+        offset   = (offset + 15) & ~15ULL;
+        pages[i] = CLITERAL (SpriteBundlePage){
+            .offset = offset,
+            .size   = (uint64_t)payload_size,
+            .width  = (uint32_t)current_project.pages[i].width,
+            .height = (uint32_t)current_project.pages[i].height,
+            .codec  = current_project.codec,
+        };
+
+        offset += pages[i].size;
+    }
+
+    SpriteBundleHeader bundle_header = CLITERAL (SpriteBundleHeader){
+        .magic          = {'R', 'S', 'P', 'X'},
+        .version        = RSP_BUNDLE_VERSION,
+        .header_size    = sizeof (SpriteBundleHeader),
+        .sections_count = lengthof (sections),
+        .file_size      = offset,
+    };
+
+    fwrite (&bundle_header, sizeof (SpriteBundleHeader), 1, output);
+    fwrite (sections, sizeof (sections), 1, output);
+
+    __write_padding (output, 16);
+    fwrite (sprites, sizeof (Sprite), current_project.sprites_count, output);
+
+    __write_padding (output, 16);
+    fwrite (frames, sizeof (Rectangle), frames_count, output);
+
+    __write_padding (output, 16);
+    fwrite (pages, sizeof (SpriteBundlePage), current_project.pages_count, output);
+
+    for (size_t i = 0; i < current_project.pages_count; i++) {
+        __write_padding (output, 16);
+        fwrite (payloads[i], sizeof (unsigned char), pages[i].size, output);
+
+        MemFree (payloads[i]);
+    }
+
+    fclose (output);
+
+    MemFree (payloads);
+    MemFree (pages);
+
+    bool exported = encoded && __export_header (directory, sprites, current_project.sprites_count);
+
+    MemFree (frames);
+    MemFree (sprites);
+
+    // NOTE: A page that failed to encode would only fail once loaded
+    if (!encoded)
+        remove (file);
+
+    return exported;
 }
 
 void RSP_LoadBundle (void) {
@@ -1098,6 +1864,144 @@ free:
     fclose (import);
 }
 
+// -----------------------------------------------------------------------------
+// Command line
+// -----------------------------------------------------------------------------
+static void* BuildWorker (void* data) {
+    RSP_BuildQueue* queue = (RSP_BuildQueue*)data;
+
+    for (;;) {
+        pthread_mutex_lock (&queue->lock);
+        int project = queue->next_project++;
+        pthread_mutex_unlock (&queue->lock);
+
+        if (project >= queue->projects_count)
+            break;
+
+        if (!BuildProject (queue->projects[project], queue->output_directory)) {
+            pthread_mutex_lock (&queue->lock);
+            queue->failed_count++;
+            pthread_mutex_unlock (&queue->lock);
+        }
+    }
+
+    return NULL;
+}
+
+// NOTE: Runs without a window, usage is
+//   sprite-bundler build <project.rspp>... [-o <directory>] [-j <jobs>]
+// Bundles go next to each project unless a directory is given, in which case
+// every project gets a folder named after it in there. Sprite paths in projects
+// are relative, so this has to run from where the editor does.
+int RSP_RunBuild (int argc, const char* argv[]) {
+    RSP_BuildQueue queue = CLITERAL (RSP_BuildQueue){0};
+    int jobs_count       = 1;
+
+    queue.projects = MemAlloc (sizeof (const char*) * MAX (argc, 1));
+
+    for (int i = 0; i < argc; i++) {
+        if (TextIsEqual (argv[i], "-o") && i + 1 < argc)
+            queue.output_directory = argv[++i];
+        else if (TextIsEqual (argv[i], "-j") && i + 1 < argc)
+            jobs_count = atoi (argv[++i]);
+        else
+            queue.projects[queue.projects_count++] = argv[i];
+    }
+
+    if (queue.projects_count == 0) {
+        fprintf (stderr, "Usage: sprite-bundler build <project%s>... [-o <directory>] [-j <jobs>]\n", DEFAULT_PROJECT_EXTENSION);
+        MemFree (queue.projects);
+
+        return 1;
+    }
+
+    jobs_count = MIN (MAX (jobs_count, 1), queue.projects_count);
+
+    // NOTE: Once projects build side by side the cores are already busy, so
+    // each packer search keeps to its own thread
+    if (jobs_count > 1)
+        pack_threads_count = 1;
+
+    SetTraceLogLevel (LOG_WARNING);
+
+    if (queue.output_directory != NULL && !DirectoryExists (queue.output_directory))
+        MakeDirectory (queue.output_directory);
+
+    pthread_mutex_init (&queue.lock, NULL);
+
+    pthread_t* threads  = MemAlloc (sizeof (pthread_t) * jobs_count);
+    int threads_started = 0;
+
+    // NOTE: The calling thread works too, so one less is spawned
+    for (int i = 1; i < jobs_count; i++) {
+        if (pthread_create (&threads[threads_started], NULL, BuildWorker, &queue) == 0)
+            threads_started++;
+    }
+
+    BuildWorker (&queue);
+
+    for (int i = 0; i < threads_started; i++)
+        pthread_join (threads[i], NULL);
+
+    pthread_mutex_destroy (&queue.lock);
+
+    MemFree (threads);
+    MemFree (queue.projects);
+
+    printf ("Built %d of %d projects\n", queue.projects_count - queue.failed_count, queue.projects_count);
+
+    return queue.failed_count > 0;
+}
+
+// Loads, repacks and exports a single project on the calling thread
+bool BuildProject (const char* project_file, const char* output_directory) {
+    if (RSP_LoadProject (project_file) != RSP_PROJECT_ERROR_NONE) {
+        fprintf (stderr, "Could not load project %s\n", project_file);
+        return false;
+    }
+
+    if (!SortSprites ()) {
+        fprintf (stderr, "A sprite in %s is too large for the atlas\n", project_file);
+        RSP_UnloadProject ();
+
+        return false;
+    }
+
+    RenderAtlas ();
+
+    char directory[MAX_FILE_PATH_LENGTH];
+
+    if (output_directory != NULL) {
+        snprintf (directory, sizeof (directory), "%s/%s", output_directory, current_project.name);
+
+        if (!DirectoryExists (directory))
+            MakeDirectory (directory);
+    } else {
+        // NOTE: GetDirectoryPath shares one buffer between threads
+        snprintf (directory, sizeof (directory), "%s", project_file);
+
+        char* separator = strrchr (directory, '/');
+        if (separator == NULL)
+            separator = strrchr (directory, '\\');
+
+        if (separator != NULL)
+            *separator = '\0';
+        else
+            snprintf (directory, sizeof (directory), ".");
+    }
+
+    bool success = RSP_ExportBundle (directory);
+
+    if (success)
+        printf ("%s -> %s/bundle%s [%d sprites, %d pages]\n", project_file, directory, DEFAULT_BUNDLE_EXTENSION, current_project.sprites_count, current_project.pages_count);
+    else
+        fprintf (stderr, "Could not write bundle for %s\n", project_file);
+
+    RSP_UnloadProject ();
+
+    return success;
+}
+
 // -----------------------------------------------------------------------------
 // Utility
 // -----------------------------------------------------------------------------
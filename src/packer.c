@@ -0,0 +1,894 @@
+// -----------------------------------------------------------------------------
+// Packer
+//
+// MaxRects keeps a list of maximal free rectangles and splits them around each
+// placement, Skyline only tracks the top edge of everything placed so far which
+// is quicker but leaves more gaps.
+// -----------------------------------------------------------------------------
+#include "packer.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// Macros
+// -----------------------------------------------------------------------------
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// -----------------------------------------------------------------------------
+// Utility
+// -----------------------------------------------------------------------------
+static int CompareTextureSizes (const void* a, const void* b) {
+    const RSP_PackRect* rect_a = (const RSP_PackRect*)a;
+    const RSP_PackRect* rect_b = (const RSP_PackRect*)b;
+
+    int mass_a = rect_a->width * rect_a->height;
+    int mass_b = rect_b->width * rect_b->height;
+
+    if (mass_a != mass_b)
+        return mass_a > mass_b ? -1 : 1;
+
+    if (rect_a->width != rect_b->width)
+        return rect_a->width > rect_b->width ? -1 : 1;
+
+    if (rect_a->height != rect_b->height)
+        return rect_a->height > rect_b->height ? -1 : 1;
+
+    // NOTE: Keeps qsort stable enough that the same input always packs the same
+    return rect_a->id - rect_b->id;
+}
+
+static int CompareMaxSides (const void* a, const void* b) {
+    const RSP_PackRect* rect_a = (const RSP_PackRect*)a;
+    const RSP_PackRect* rect_b = (const RSP_PackRect*)b;
+
+    int side_a = MAX (rect_a->width, rect_a->height);
+    int side_b = MAX (rect_b->width, rect_b->height);
+
+    if (side_a != side_b)
+        return side_a > side_b ? -1 : 1;
+
+    return CompareTextureSizes (a, b);
+}
+
+static int ComparePerimeters (const void* a, const void* b) {
+    const RSP_PackRect* rect_a = (const RSP_PackRect*)a;
+    const RSP_PackRect* rect_b = (const RSP_PackRect*)b;
+
+    int perimeter_a = rect_a->width + rect_a->height;
+    int perimeter_b = rect_b->width + rect_b->height;
+
+    if (perimeter_a != perimeter_b)
+        return perimeter_a > perimeter_b ? -1 : 1;
+
+    return CompareTextureSizes (a, b);
+}
+
+static int CompareWidths (const void* a, const void* b) {
+    const RSP_PackRect* rect_a = (const RSP_PackRect*)a;
+    const RSP_PackRect* rect_b = (const RSP_PackRect*)b;
+
+    if (rect_a->width != rect_b->width)
+        return rect_a->width > rect_b->width ? -1 : 1;
+
+    return CompareTextureSizes (a, b);
+}
+
+static int CompareHeights (const void* a, const void* b) {
+    const RSP_PackRect* rect_a = (const RSP_PackRect*)a;
+    const RSP_PackRect* rect_b = (const RSP_PackRect*)b;
+
+    if (rect_a->height != rect_b->height)
+        return rect_a->height > rect_b->height ? -1 : 1;
+
+    return CompareTextureSizes (a, b);
+}
+
+static void SortRects (RSP_PackRect* rects, int count, RSP_PackSort sort) {
+    int (*comparators[RSP_PACK_SORT_COUNT]) (const void*, const void*) = {
+        [RSP_PACK_SORT_AREA]      = CompareTextureSizes,
+        [RSP_PACK_SORT_MAX_SIDE]  = CompareMaxSides,
+        [RSP_PACK_SORT_PERIMETER] = ComparePerimeters,
+        [RSP_PACK_SORT_WIDTH]     = CompareWidths,
+        [RSP_PACK_SORT_HEIGHT]    = CompareHeights,
+    };
+
+    qsort (rects, count, sizeof (RSP_PackRect), comparators[sort < RSP_PACK_SORT_COUNT ? sort : RSP_PACK_SORT_AREA]);
+}
+
+static int GetProcessorCount (void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo (&info);
+
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf (_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+// Rounds the footprint up to the alignment but never past the page
+static int AlignSize (int value, int alignment, int limit) {
+    if (alignment > 1)
+        value = ((value + alignment - 1) / alignment) * alignment;
+
+    return MIN (value, limit);
+}
+
+// NOTE: Both scores are folded into one value so orientations can be compared,
+// lower is better
+static int64_t PackScore (int primary, int secondary) {
+    return ((int64_t)primary << 32) | (uint32_t)secondary;
+}
+
+static bool IsBoxContained (RSP_PackBox a, RSP_PackBox b) {
+    return (a.x >= b.x) & (a.y >= b.y) & (a.x + a.width <= b.x + b.width) & (a.y + a.height <= b.y + b.height);
+}
+
+static bool IsBoxOverlapping (RSP_PackBox a, RSP_PackBox b) {
+    return (a.x < b.x + b.width) & (a.x + a.width > b.x) & (a.y < b.y + b.height) & (a.y + a.height > b.y);
+}
+
+static void PushFreeBox (RSP_Packer* packer, RSP_PackBox box) {
+    if (packer->free_boxes_count == packer->free_boxes_capacity) {
+        packer->free_boxes_capacity = MAX (16, packer->free_boxes_capacity * 2);
+        packer->free_boxes          = realloc (packer->free_boxes, packer->free_boxes_capacity * sizeof (RSP_PackBox));
+    }
+
+    packer->free_boxes[packer->free_boxes_count++] = box;
+}
+
+// -----------------------------------------------------------------------------
+// MaxRects
+// -----------------------------------------------------------------------------
+static bool FindMaxRectsPosition (RSP_Packer* packer, int width, int height, RSP_PackBox* result, int64_t* score) {
+    int best_primary   = INT_MAX;
+    int best_secondary = INT_MAX;
+
+    for (int i = 0; i < packer->free_boxes_count; i++) {
+        RSP_PackBox box = packer->free_boxes[i];
+
+        if (box.width < width || box.height < height)
+            continue;
+
+        int leftover_x = box.width - width;
+        int leftover_y = box.height - height;
+
+        int primary, secondary;
+
+        switch (packer->options.heuristic) {
+            case RSP_PACK_BEST_LONG_SIDE:
+                primary   = MAX (leftover_x, leftover_y);
+                secondary = MIN (leftover_x, leftover_y);
+                break;
+
+            case RSP_PACK_BEST_AREA:
+            case RSP_PACK_MIN_WASTE:
+                primary   = box.width * box.height - width * height;
+                secondary = MIN (leftover_x, leftover_y);
+                break;
+
+            case RSP_PACK_BOTTOM_LEFT:
+                primary   = box.y + height;
+                secondary = box.x;
+                break;
+
+            case RSP_PACK_BEST_SHORT_SIDE:
+            default:
+                primary   = MIN (leftover_x, leftover_y);
+                secondary = MAX (leftover_x, leftover_y);
+                break;
+        }
+
+        if (primary < best_primary || (primary == best_primary && secondary < best_secondary)) {
+            best_primary   = primary;
+            best_secondary = secondary;
+
+            *result = (RSP_PackBox){box.x, box.y, width, height};
+        }
+    }
+
+    *score = PackScore (best_primary, best_secondary);
+
+    return best_primary != INT_MAX;
+}
+
+// Splits every free box touched by the placement, then drops any box that is
+// now contained by another. Only freshly split boxes need checking as the
+// untouched ones were already maximal.
+static void SplitFreeBoxes (RSP_Packer* packer, RSP_PackBox used) {
+    int original_count = packer->free_boxes_count;
+
+    for (int i = 0; i < original_count; i++) {
+        RSP_PackBox box = packer->free_boxes[i];
+
+        if (!IsBoxOverlapping (box, used))
+            continue;
+
+        if (used.x > box.x)
+            PushFreeBox (packer, (RSP_PackBox){box.x, box.y, used.x - box.x, box.height});
+
+        if (used.x + used.width < box.x + box.width)
+            PushFreeBox (packer, (RSP_PackBox){used.x + used.width, box.y, box.x + box.width - (used.x + used.width), box.height});
+
+        if (used.y > box.y)
+            PushFreeBox (packer, (RSP_PackBox){box.x, box.y, box.width, used.y - box.y});
+
+        if (used.y + used.height < box.y + box.height)
+            PushFreeBox (packer, (RSP_PackBox){box.x, used.y + used.height, box.width, box.y + box.height - (used.y + used.height)});
+
+        packer->free_boxes[i].width = 0;
+    }
+
+    // Compact so survivors come first and new boxes follow
+    int count     = 0;
+    int new_start = 0;
+
+    for (int i = 0; i < packer->free_boxes_count; i++) {
+        if (i == original_count)
+            new_start = count;
+
+        if (packer->free_boxes[i].width > 0)
+            packer->free_boxes[count++] = packer->free_boxes[i];
+    }
+
+    if (original_count == packer->free_boxes_count)
+        new_start = count;
+
+    packer->free_boxes_count = count;
+
+    // NOTE: A new box can never contain an untouched one as that box would
+    // already have been inside the box that was split
+    for (int i = new_start; i < packer->free_boxes_count; i++) {
+        RSP_PackBox* box = &packer->free_boxes[i];
+
+        for (int j = 0; j < new_start; j++) {
+            if (IsBoxContained (*box, packer->free_boxes[j])) {
+                box->width = 0;
+                break;
+            }
+        }
+
+        for (int j = new_start; j < packer->free_boxes_count && box->width > 0; j++) {
+            RSP_PackBox* other = &packer->free_boxes[j];
+
+            if (i == j || other->width == 0)
+                continue;
+
+            if (IsBoxContained (*box, *other))
+                box->width = 0;
+            else if (IsBoxContained (*other, *box))
+                other->width = 0;
+        }
+    }
+
+    count = 0;
+    for (int i = 0; i < packer->free_boxes_count; i++) {
+        if (packer->free_boxes[i].width > 0)
+            packer->free_boxes[count++] = packer->free_boxes[i];
+    }
+
+    packer->free_boxes_count = count;
+}
+
+
+// -----------------------------------------------------------------------------
+// Skyline
+// -----------------------------------------------------------------------------
+// NOTE: Anything reaching past the ceiling is rejected early, waste is only
+// measured when asked for
+static bool SkylineFits (RSP_Packer* packer, int index, int width, int height, int ceiling, int* y, int* waste) {
+    int x = packer->skyline[index].x;
+
+    if (x + width > packer->options.width)
+        return false;
+
+    int top        = packer->skyline[index].y;
+    int width_left = width;
+
+    for (int i = index; width_left > 0; i++) {
+        top = MAX (top, packer->skyline[i].y);
+
+        if (top + height > ceiling)
+            return false;
+
+        width_left -= packer->skyline[i].width;
+    }
+
+    *y = top;
+
+    if (waste == NULL)
+        return true;
+
+    // Area left unreachable underneath the rect
+    int wasted = 0;
+    width_left = width;
+
+    for (int i = index; width_left > 0; i++) {
+        int span = MIN (width_left, packer->skyline[i].width);
+
+        wasted += (top - packer->skyline[i].y) * span;
+        width_left -= span;
+    }
+
+    *waste = wasted;
+
+    return true;
+}
+
+static void InsertSkylineNode (RSP_Packer* packer, int index, RSP_SkylineNode node) {
+    if (packer->skyline_count == packer->skyline_capacity) {
+        packer->skyline_capacity = MAX (16, packer->skyline_capacity * 2);
+        packer->skyline          = realloc (packer->skyline, packer->skyline_capacity * sizeof (RSP_SkylineNode));
+    }
+
+    for (int i = packer->skyline_count; i > index; i--)
+        packer->skyline[i] = packer->skyline[i - 1];
+
+    packer->skyline[index] = node;
+    packer->skyline_count++;
+}
+
+static void MergeSkyline (RSP_Packer* packer) {
+    for (int i = 0; i < packer->skyline_count - 1; i++) {
+        if (packer->skyline[i].y != packer->skyline[i + 1].y)
+            continue;
+
+        packer->skyline[i].width += packer->skyline[i + 1].width;
+
+        for (int j = i + 1; j < packer->skyline_count - 1; j++)
+            packer->skyline[j] = packer->skyline[j + 1];
+
+        packer->skyline_count--;
+        i--;
+    }
+}
+
+static void AddSkylineLevel (RSP_Packer* packer, int index, RSP_PackBox box) {
+    InsertSkylineNode (packer, index, (RSP_SkylineNode){box.x, box.y + box.height, box.width});
+
+    // Trim nodes now hidden under the new level
+    for (int i = index + 1; i < packer->skyline_count; i++) {
+        RSP_SkylineNode* previous = &packer->skyline[i - 1];
+        RSP_SkylineNode* current  = &packer->skyline[i];
+
+        int right = previous->x + previous->width;
+        if (current->x >= right)
+            break;
+
+        int shrink = right - current->x;
+
+        current->x += shrink;
+        current->width -= shrink;
+
+        if (current->width > 0)
+            break;
+
+        for (int j = i; j < packer->skyline_count - 1; j++)
+            packer->skyline[j] = packer->skyline[j + 1];
+
+        packer->skyline_count--;
+        i--;
+    }
+
+    MergeSkyline (packer);
+}
+
+// NOTE: The skyline can't represent holes, so everything underneath an
+// occupied box is given up
+static void RaiseSkyline (RSP_Packer* packer, RSP_PackBox box) {
+    int left  = box.x;
+    int right = box.x + box.width;
+
+    for (int i = 0; i < packer->skyline_count; i++) {
+        RSP_SkylineNode* node = &packer->skyline[i];
+        int node_right        = node->x + node->width;
+
+        if (node_right <= left || node->x >= right)
+            continue;
+
+        // Split so only whole nodes sit inside the box span
+        if (node->x < left) {
+            InsertSkylineNode (packer, i + 1, (RSP_SkylineNode){left, node->y, node_right - left});
+            packer->skyline[i].width = left - packer->skyline[i].x;
+            continue;
+        }
+
+        if (node_right > right) {
+            InsertSkylineNode (packer, i + 1, (RSP_SkylineNode){right, node->y, node_right - right});
+            packer->skyline[i].width = right - packer->skyline[i].x;
+        }
+
+        packer->skyline[i].y = MAX (packer->skyline[i].y, box.y + box.height);
+    }
+
+    MergeSkyline (packer);
+}
+
+static bool FindSkylinePosition (RSP_Packer* packer, int width, int height, RSP_PackBox* result, int64_t* score, int* index) {
+    int best_index     = -1;
+    int best_primary   = INT_MAX;
+    int best_secondary = INT_MAX;
+
+    bool min_waste = packer->options.heuristic == RSP_PACK_MIN_WASTE;
+
+    for (int i = 0; i < packer->skyline_count; i++) {
+        int y, waste;
+        int ceiling = MIN (packer->options.height, best_primary);
+
+        if (!SkylineFits (packer, i, width, height, ceiling, &y, min_waste ? &waste : NULL))
+            continue;
+
+        int primary   = y + height;
+        int secondary = packer->skyline[i].width;
+
+        // NOTE: Waste alone happily stacks tall columns, so it is charged as
+        // extra height instead
+        if (min_waste) {
+            primary   = y + height + waste / width;
+            secondary = waste;
+        }
+
+        if (primary < best_primary || (primary == best_primary && secondary < best_secondary)) {
+            best_index     = i;
+            best_primary   = primary;
+            best_secondary = secondary;
+
+            *result = (RSP_PackBox){packer->skyline[i].x, y, width, height};
+        }
+    }
+
+    *index = best_index;
+    *score = PackScore (best_primary, best_secondary);
+
+    return best_index >= 0;
+}
+
+static bool FindPosition (RSP_Packer* packer, int width, int height, RSP_PackBox* result, int64_t* score, int* index) {
+    if (packer->options.method == RSP_PACK_SKYLINE)
+        return FindSkylinePosition (packer, width, height, result, score, index);
+
+    return FindMaxRectsPosition (packer, width, height, result, score);
+}
+
+// NOTE: Footprint of a rect on the page, swapped when rotated
+static void GetRectFootprint (RSP_PackRect rect, int* width, int* height) {
+    *width  = rect.rotated ? rect.height : rect.width;
+    *height = rect.rotated ? rect.width : rect.height;
+}
+
+static bool IsRectTooLarge (RSP_PackRect rect, RSP_PackOptions options) {
+    if (rect.width <= options.width && rect.height <= options.height)
+        return false;
+
+    return !options.allow_rotation || rect.height > options.width || rect.width > options.height;
+}
+
+// -----------------------------------------------------------------------------
+// Packer
+// -----------------------------------------------------------------------------
+RSP_Packer RSP_InitPacker (RSP_PackOptions options) {
+    RSP_Packer packer = {0};
+
+    packer.options = options;
+
+    if (options.method == RSP_PACK_SKYLINE) {
+        packer.skyline_capacity = 16;
+        packer.skyline          = malloc (packer.skyline_capacity * sizeof (RSP_SkylineNode));
+
+        packer.skyline[packer.skyline_count++] = (RSP_SkylineNode){0, 0, options.width};
+    } else {
+        PushFreeBox (&packer, (RSP_PackBox){0, 0, options.width, options.height});
+    }
+
+    return packer;
+}
+
+void RSP_UnloadPacker (RSP_Packer packer) {
+    free (packer.free_boxes);
+    free (packer.skyline);
+}
+
+void RSP_PackerOccupy (RSP_Packer* packer, RSP_PackRect rect) {
+    int width, height;
+    GetRectFootprint (rect, &width, &height);
+
+    RSP_PackBox box = (RSP_PackBox){
+        rect.x,
+        rect.y,
+        AlignSize (width, packer->options.alignment, packer->options.width - rect.x),
+        AlignSize (height, packer->options.alignment, packer->options.height - rect.y),
+    };
+
+    if (box.width <= 0 || box.height <= 0)
+        return;
+
+    if (packer->options.method == RSP_PACK_SKYLINE)
+        RaiseSkyline (packer, box);
+    else
+        SplitFreeBoxes (packer, box);
+
+    packer->used_area += (int64_t)box.width * box.height;
+}
+
+bool RSP_PackerInsert (RSP_Packer* packer, RSP_PackRect* rect) {
+    rect->packed  = false;
+    rect->rotated = false;
+
+    if (rect->width <= 0 || rect->height <= 0 || IsRectTooLarge (*rect, packer->options))
+        return false;
+
+    int width  = AlignSize (rect->width, packer->options.alignment, packer->options.width);
+    int height = AlignSize (rect->height, packer->options.alignment, packer->options.height);
+
+    RSP_PackBox result = {0};
+    int64_t score      = INT64_MAX;
+    int index          = -1;
+
+    bool success = rect->width <= packer->options.width && rect->height <= packer->options.height
+                   && FindPosition (packer, width, height, &result, &score, &index);
+
+    if (packer->options.allow_rotation && rect->width != rect->height) {
+        int rotated_width  = AlignSize (rect->height, packer->options.alignment, packer->options.width);
+        int rotated_height = AlignSize (rect->width, packer->options.alignment, packer->options.height);
+
+        RSP_PackBox rotated_result = {0};
+        int64_t rotated_score      = INT64_MAX;
+        int rotated_index          = -1;
+
+        bool fits = rect->height <= packer->options.width && rect->width <= packer->options.height
+                    && FindPosition (packer, rotated_width, rotated_height, &rotated_result, &rotated_score, &rotated_index);
+
+        if (fits && (!success || rotated_score < score)) {
+            result        = rotated_result;
+            index         = rotated_index;
+            rect->rotated = true;
+            success       = true;
+        }
+    }
+
+    if (!success)
+        return false;
+
+    if (packer->options.method == RSP_PACK_SKYLINE)
+        AddSkylineLevel (packer, index, result);
+    else
+        SplitFreeBoxes (packer, result);
+
+    rect->x      = result.x;
+    rect->y      = result.y;
+    rect->packed = true;
+
+    packer->used_area += (int64_t)result.width * result.height;
+
+    return true;
+}
+
+// NOTE: Gives up and returns -1 as soon as more than pages_limit pages are
+// needed, the search uses this to drop layouts that can no longer win. Pages
+// opened before giving up are unloaded, the caller only owns what it passed in
+static int PackIntoPages (RSP_Packer** pages, int pages_count, RSP_PackRect* rects, int count, RSP_PackOptions options, int pages_limit) {
+    // NOTE: A rect too large for any page would never be placed however many
+    // pages are opened, so nothing is packed at all
+    for (int i = 0; i < count; i++) {
+        if (IsRectTooLarge (rects[i], options))
+            return -1;
+    }
+
+    SortRects (rects, count, options.sort);
+
+    int pages_start = pages_count;
+    bool exceeded   = false;
+
+    for (int i = 0; i < count; i++) {
+        RSP_PackRect* rect = &rects[i];
+
+        for (rect->page = 0; rect->page < pages_count; rect->page++) {
+            if (RSP_PackerInsert (&(*pages)[rect->page], rect))
+                break;
+        }
+
+        if (rect->page < pages_count)
+            continue;
+
+        if (pages_count == pages_limit) {
+            exceeded = true;
+            break;
+        }
+
+        *pages                  = realloc (*pages, (pages_count + 1) * sizeof (RSP_Packer));
+        (*pages)[pages_count++] = RSP_InitPacker (options);
+
+        RSP_PackerInsert (&(*pages)[rect->page], rect);
+    }
+
+    if (exceeded) {
+        for (int i = pages_start; i < pages_count; i++)
+            RSP_UnloadPacker ((*pages)[i]);
+
+        return -1;
+    }
+
+    return pages_count;
+}
+
+static int PackRectsLimited (RSP_PackRect* rects, int count, RSP_PackOptions options, int pages_limit) {
+    RSP_Packer* pages = NULL;
+    int pages_count   = PackIntoPages (&pages, 0, rects, count, options, pages_limit);
+
+    for (int i = 0; i < pages_count; i++)
+        RSP_UnloadPacker (pages[i]);
+
+    free (pages);
+
+    return pages_count;
+}
+
+int RSP_PackRects (RSP_PackRect* rects, int count, RSP_PackOptions options) {
+    return PackRectsLimited (rects, count, options, INT_MAX);
+}
+
+int RSP_PackRectsInto (RSP_Packer** pages, int pages_count, RSP_PackRect* rects, int count, RSP_PackOptions options) {
+    return PackIntoPages (pages, pages_count, rects, count, options, INT_MAX);
+}
+
+// Sum of every page's used bounds, the last page is usually the one that shrinks
+int64_t RSP_GetPackedArea (const RSP_PackRect* rects, int count, int pages_count) {
+    RSP_PackBox* bounds = calloc (pages_count, sizeof (RSP_PackBox));
+
+    for (int i = 0; i < count; i++) {
+        const RSP_PackRect* rect = &rects[i];
+
+        if (!rect->packed)
+            continue;
+
+        RSP_PackBox* page = &bounds[rect->page];
+
+        int width, height;
+        GetRectFootprint (*rect, &width, &height);
+
+        page->width  = MAX (page->width, rect->x + width);
+        page->height = MAX (page->height, rect->y + height);
+    }
+
+    int64_t area = 0;
+    for (int i = 0; i < pages_count; i++)
+        area += (int64_t)bounds[i].width * bounds[i].height;
+
+    free (bounds);
+
+    return area;
+}
+
+// -----------------------------------------------------------------------------
+// Search
+// -----------------------------------------------------------------------------
+static const struct {
+    RSP_PackMethod method;
+    RSP_PackHeuristic heuristic;
+} pack_strategies[] = {
+    {RSP_PACK_MAXRECTS, RSP_PACK_BEST_SHORT_SIDE},
+    {RSP_PACK_MAXRECTS, RSP_PACK_BEST_LONG_SIDE },
+    {RSP_PACK_MAXRECTS, RSP_PACK_BEST_AREA      },
+    {RSP_PACK_MAXRECTS, RSP_PACK_BOTTOM_LEFT    },
+    {RSP_PACK_SKYLINE,  RSP_PACK_BOTTOM_LEFT    },
+    {RSP_PACK_SKYLINE,  RSP_PACK_MIN_WASTE      },
+};
+
+#define PACK_CANDIDATES_COUNT (RSP_PACK_SORT_COUNT * (int)(sizeof (pack_strategies) / sizeof (pack_strategies[0])))
+
+typedef struct RSP_PackSearch {
+    const RSP_PackRect* input;
+    int count;
+    RSP_PackOptions options;
+
+    pthread_mutex_t lock;
+    int next_candidate;
+
+    RSP_PackRect* best;
+    RSP_PackOptions best_options;
+    int best_candidate;
+    int best_pages;
+    int64_t best_area;
+} RSP_PackSearch;
+
+static void* PackSearchWorker (void* data) {
+    RSP_PackSearch* search = (RSP_PackSearch*)data;
+    RSP_PackRect* rects    = malloc (search->count * sizeof (RSP_PackRect));
+
+    for (;;) {
+        pthread_mutex_lock (&search->lock);
+        int candidate   = search->next_candidate++;
+        int pages_limit = search->best_pages;
+        pthread_mutex_unlock (&search->lock);
+
+        if (candidate >= PACK_CANDIDATES_COUNT)
+            break;
+
+        RSP_PackOptions options = search->options;
+
+        options.sort      = (RSP_PackSort)(candidate % RSP_PACK_SORT_COUNT);
+        options.method    = pack_strategies[candidate / RSP_PACK_SORT_COUNT].method;
+        options.heuristic = pack_strategies[candidate / RSP_PACK_SORT_COUNT].heuristic;
+
+        memcpy (rects, search->input, search->count * sizeof (RSP_PackRect));
+
+        int pages = PackRectsLimited (rects, search->count, options, pages_limit);
+        if (pages < 0)
+            continue;
+
+        int64_t area = RSP_GetPackedArea (rects, search->count, pages);
+
+        pthread_mutex_lock (&search->lock);
+
+        // NOTE: Ties go to the earliest candidate so the layout doesn't depend
+        // on which thread happened to finish first
+        bool better = pages < search->best_pages
+                      || (pages == search->best_pages && (area < search->best_area || (area == search->best_area && candidate < search->best_candidate)));
+
+        if (better) {
+            // Hand our buffer over and carry on with the old best one
+            RSP_PackRect* previous = search->best;
+
+            search->best           = rects;
+            search->best_options   = options;
+            search->best_candidate = candidate;
+            search->best_pages     = pages;
+            search->best_area      = area;
+
+            rects = previous;
+        }
+
+        pthread_mutex_unlock (&search->lock);
+    }
+
+    free (rects);
+
+    return NULL;
+}
+
+// NOTE: Only layouts within pages_limit pages are considered, returns -1 and
+// leaves rects untouched when none of them fit
+static int PackRectsSearch (RSP_PackRect* rects, int count, RSP_PackOptions* options, int threads_count, int pages_limit) {
+    if (threads_count <= 0)
+        threads_count = GetProcessorCount ();
+
+    threads_count = MIN (threads_count, PACK_CANDIDATES_COUNT);
+
+    RSP_PackSearch search = {
+        .input          = rects,
+        .count          = count,
+        .options        = *options,
+        .best           = malloc (count * sizeof (RSP_PackRect)),
+        .best_options   = *options,
+        .best_candidate = PACK_CANDIDATES_COUNT,
+        .best_pages     = pages_limit,
+        .best_area      = INT64_MAX,
+    };
+
+    pthread_mutex_init (&search.lock, NULL);
+
+    pthread_t* threads = malloc (threads_count * sizeof (pthread_t));
+    int threads_started = 0;
+
+    // NOTE: The calling thread works too, so one less is spawned
+    for (int i = 1; i < threads_count; i++) {
+        if (pthread_create (&threads[threads_started], NULL, PackSearchWorker, &search) == 0)
+            threads_started++;
+    }
+
+    PackSearchWorker (&search);
+
+    for (int i = 0; i < threads_started; i++)
+        pthread_join (threads[i], NULL);
+
+    pthread_mutex_destroy (&search.lock);
+    free (threads);
+
+    bool found = search.best_area != INT64_MAX;
+
+    if (found) {
+        memcpy (rects, search.best, count * sizeof (RSP_PackRect));
+
+        *options = search.best_options;
+    }
+
+    free (search.best);
+
+    return found ? search.best_pages : -1;
+}
+
+int RSP_PackRectsBest (RSP_PackRect* rects, int count, RSP_PackOptions* options, int threads_count) {
+    return PackRectsSearch (rects, count, options, threads_count, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+// Page size search
+// -----------------------------------------------------------------------------
+#define PACK_MIN_PAGE_SIZE 16
+
+static int ComparePageSizes (const void* a, const void* b) {
+    const RSP_PackBox* page_a = (const RSP_PackBox*)a;
+    const RSP_PackBox* page_b = (const RSP_PackBox*)b;
+
+    int64_t area_a = (int64_t)page_a->width * page_a->height;
+    int64_t area_b = (int64_t)page_b->width * page_b->height;
+
+    if (area_a != area_b)
+        return area_a < area_b ? -1 : 1;
+
+    // Squarer pages first, then wider ones
+    int skew_a = abs (page_a->width - page_a->height);
+    int skew_b = abs (page_b->width - page_b->height);
+
+    if (skew_a != skew_b)
+        return skew_a - skew_b;
+
+    return page_b->width - page_a->width;
+}
+
+int RSP_PackRectsSmallest (RSP_PackRect* rects, int count, RSP_PackOptions* options, bool square, int threads_count) {
+    int64_t rects_area = 0;
+
+    for (int i = 0; i < count; i++)
+        rects_area += (int64_t)rects[i].width * rects[i].height;
+
+    RSP_PackBox* sizes = NULL;
+    int sizes_count    = 0;
+
+    for (int width = PACK_MIN_PAGE_SIZE; width <= options->width; width *= 2) {
+        for (int height = PACK_MIN_PAGE_SIZE; height <= options->height; height *= 2) {
+            if (square && width != height)
+                continue;
+
+            // NOTE: Anything smaller than the rects themselves can never fit
+            if ((int64_t)width * height < rects_area)
+                continue;
+
+            sizes                = realloc (sizes, (sizes_count + 1) * sizeof (RSP_PackBox));
+            sizes[sizes_count++] = (RSP_PackBox){0, 0, width, height};
+        }
+    }
+
+    qsort (sizes, sizes_count, sizeof (RSP_PackBox), ComparePageSizes);
+
+    int pages_count = -1;
+
+    for (int i = 0; i < sizes_count && pages_count < 0; i++) {
+        RSP_PackOptions candidate = *options;
+
+        candidate.width  = sizes[i].width;
+        candidate.height = sizes[i].height;
+
+        bool too_large = false;
+        for (int j = 0; j < count && !too_large; j++)
+            too_large = IsRectTooLarge (rects[j], candidate);
+
+        if (too_large)
+            continue;
+
+        pages_count = PackRectsSearch (rects, count, &candidate, threads_count, 1);
+
+        if (pages_count >= 0)
+            *options = candidate;
+    }
+
+    free (sizes);
+
+    // NOTE: Not even the largest page holds everything, spill onto more pages
+    if (pages_count < 0)
+        pages_count = PackRectsSearch (rects, count, options, threads_count, INT_MAX);
+
+    return pages_count;
+}
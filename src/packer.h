@@ -0,0 +1,134 @@
+// -----------------------------------------------------------------------------
+// Packer
+//
+// Rectangle packing engine used to place sprites on the atlas, supports both
+// MaxRects and Skyline placement with a handful of scoring heuristics.
+// -----------------------------------------------------------------------------
+#ifndef RSP_PACKER_H
+#define RSP_PACKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Enums
+// -----------------------------------------------------------------------------
+typedef enum RSP_PackMethod {
+    RSP_PACK_MAXRECTS,
+    RSP_PACK_SKYLINE,
+} RSP_PackMethod;
+
+// NOTE: Skyline only supports bottom left & min waste, MaxRects supports every
+// heuristic but treats min waste as best area
+typedef enum RSP_PackHeuristic {
+    RSP_PACK_BEST_SHORT_SIDE,
+    RSP_PACK_BEST_LONG_SIDE,
+    RSP_PACK_BEST_AREA,
+    RSP_PACK_BOTTOM_LEFT,
+    RSP_PACK_MIN_WASTE,
+} RSP_PackHeuristic;
+
+// NOTE: All sort orders are largest first
+typedef enum RSP_PackSort {
+    RSP_PACK_SORT_AREA,
+    RSP_PACK_SORT_MAX_SIDE,
+    RSP_PACK_SORT_PERIMETER,
+    RSP_PACK_SORT_WIDTH,
+    RSP_PACK_SORT_HEIGHT,
+    RSP_PACK_SORT_COUNT,
+} RSP_PackSort;
+
+// -----------------------------------------------------------------------------
+// Type definitions
+// -----------------------------------------------------------------------------
+typedef struct RSP_PackRect {
+    int id;
+
+    int width;
+    int height;
+
+    int x;
+    int y;
+    int page;
+
+    bool packed;
+    bool rotated;
+} RSP_PackRect;
+
+typedef struct RSP_PackOptions {
+    int width;
+    int height;
+    int alignment;
+
+    // NOTE: Rects may be turned 90 degrees clockwise when it scores better,
+    // rotated rects keep their original width & height
+    bool allow_rotation;
+
+    RSP_PackSort sort;
+    RSP_PackMethod method;
+    RSP_PackHeuristic heuristic;
+} RSP_PackOptions;
+
+typedef struct RSP_PackBox {
+    int x;
+    int y;
+    int width;
+    int height;
+} RSP_PackBox;
+
+typedef struct RSP_SkylineNode {
+    int x;
+    int y;
+    int width;
+} RSP_SkylineNode;
+
+typedef struct RSP_Packer {
+    RSP_PackOptions options;
+
+    RSP_PackBox* free_boxes;
+    int free_boxes_count;
+    int free_boxes_capacity;
+
+    RSP_SkylineNode* skyline;
+    int skyline_count;
+    int skyline_capacity;
+
+    int64_t used_area;
+} RSP_Packer;
+
+// -----------------------------------------------------------------------------
+// Function decleration
+// -----------------------------------------------------------------------------
+RSP_Packer RSP_InitPacker (RSP_PackOptions options);
+void RSP_UnloadPacker (RSP_Packer packer);
+
+bool RSP_PackerInsert (RSP_Packer* packer, RSP_PackRect* rect);
+
+// Marks an already placed rect as used so new rects are packed around it,
+// rotated rects occupy their swapped footprint
+void RSP_PackerOccupy (RSP_Packer* packer, RSP_PackRect rect);
+
+// NOTE: Sorts rects largest first and opens a new page whenever a rect fits
+// nowhere else, returns the amount of pages used. Every packing function
+// returns -1 without packing anything when a rect is larger than a page
+int RSP_PackRects (RSP_PackRect* rects, int count, RSP_PackOptions options);
+
+// Same as above but fills the given pages first, the array is grown whenever
+// a page is opened, returns the new amount of pages
+int RSP_PackRectsInto (RSP_Packer** pages, int pages_count, RSP_PackRect* rects, int count, RSP_PackOptions options);
+
+// Packs with every sort order, method and heuristic across a pool of threads
+// and keeps the layout with the fewest pages, then the smallest used area.
+// The winning combination is written back to options, 0 threads uses one per
+// core.
+int RSP_PackRectsBest (RSP_PackRect* rects, int count, RSP_PackOptions* options, int threads_count);
+
+// Searches power of two page sizes up to options width & height for the
+// smallest single page that holds every rect, falling back to several pages of
+// the largest size. The chosen size is written back to options along with the
+// winning strategy.
+int RSP_PackRectsSmallest (RSP_PackRect* rects, int count, RSP_PackOptions* options, bool square, int threads_count);
+
+int64_t RSP_GetPackedArea (const RSP_PackRect* rects, int count, int pages_count);
+
+#endif // RSP_PACKER_H
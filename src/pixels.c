@@ -0,0 +1,203 @@
+// -----------------------------------------------------------------------------
+// Pixels
+//
+// Pixels are expected as tightly packed R8G8B8A8, scans use SSE2 when the
+// compiler has it enabled and fall back to plain loops otherwise.
+// -----------------------------------------------------------------------------
+#include "pixels.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// Scanning
+// -----------------------------------------------------------------------------
+
+// Index of the first pixel with any alpha, or count when there is none
+static int FindFirstOpaque (const uint8_t* row, int count) {
+    int i = 0;
+
+#ifdef __SSE2__
+    const __m128i alpha_mask = _mm_set1_epi32 ((int)0xFF000000);
+    const __m128i zero       = _mm_setzero_si128 ();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i chunk = _mm_and_si128 (_mm_loadu_si128 ((const __m128i*)(row + i * 4)), alpha_mask);
+
+        if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (chunk, zero)) != 0xFFFF)
+            break;
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (row[i * 4 + 3] != 0)
+            return i;
+    }
+
+    return count;
+}
+
+// Index of the last pixel with any alpha, or -1 when there is none
+static int FindLastOpaque (const uint8_t* row, int count) {
+    int i = count;
+
+#ifdef __SSE2__
+    const __m128i alpha_mask = _mm_set1_epi32 ((int)0xFF000000);
+    const __m128i zero       = _mm_setzero_si128 ();
+
+    for (; i - 4 >= 0; i -= 4) {
+        __m128i chunk = _mm_and_si128 (_mm_loadu_si128 ((const __m128i*)(row + (i - 4) * 4)), alpha_mask);
+
+        if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (chunk, zero)) != 0xFFFF)
+            break;
+    }
+#endif
+
+    for (i = i - 1; i >= 0; i--) {
+        if (row[i * 4 + 3] != 0)
+            return i;
+    }
+
+    return -1;
+}
+
+RSP_PixelBounds RSP_GetOpaqueBounds (const uint8_t* pixels, int width, int height) {
+    const int stride = width * 4;
+
+    int top = 0;
+    while (top < height && FindFirstOpaque (pixels + top * stride, width) == width)
+        top++;
+
+    if (top == height)
+        return (RSP_PixelBounds){0, 0, 1, 1};
+
+    int bottom = height - 1;
+    while (bottom > top && FindFirstOpaque (pixels + bottom * stride, width) == width)
+        bottom--;
+
+    // NOTE: Each row only needs scanning up to the bounds found so far
+    int left  = width;
+    int right = -1;
+
+    for (int y = top; y <= bottom; y++) {
+        const uint8_t* row = pixels + y * stride;
+
+        int first = FindFirstOpaque (row, left);
+        if (first < left)
+            left = first;
+
+        int last = FindLastOpaque (row + (right + 1) * 4, width - (right + 1));
+        if (last >= 0)
+            right += last + 1;
+    }
+
+    return (RSP_PixelBounds){left, top, right - left + 1, bottom - top + 1};
+}
+
+// -----------------------------------------------------------------------------
+// Hashing
+// -----------------------------------------------------------------------------
+
+// NOTE: Mixes a whole pixel at a time rather than FNV's byte at a time, the
+// size goes in first so rows can't line up differently and collide
+uint64_t RSP_HashPixels (const uint8_t* pixels, int width, RSP_PixelBounds bounds) {
+    uint64_t hash = 14695981039346656037ULL ^ ((uint64_t)bounds.width << 32 | (uint32_t)bounds.height);
+
+    for (int y = bounds.y; y < bounds.y + bounds.height; y++) {
+        const uint8_t* row = pixels + ((size_t)y * width + bounds.x) * 4;
+
+        for (int x = 0; x < bounds.width; x++) {
+            uint32_t pixel;
+            memcpy (&pixel, row + x * 4, sizeof (uint32_t));
+
+            hash ^= pixel;
+            hash *= 0x9E3779B97F4A7C15ULL;
+            hash ^= hash >> 29;
+        }
+    }
+
+    return hash;
+}
+
+bool RSP_ComparePixels (const uint8_t* a, int a_width, RSP_PixelBounds a_bounds, const uint8_t* b, int b_width, RSP_PixelBounds b_bounds) {
+    if (a_bounds.width != b_bounds.width || a_bounds.height != b_bounds.height)
+        return false;
+
+    for (int y = 0; y < a_bounds.height; y++) {
+        const uint8_t* row_a = a + ((size_t)(a_bounds.y + y) * a_width + a_bounds.x) * 4;
+        const uint8_t* row_b = b + ((size_t)(b_bounds.y + y) * b_width + b_bounds.x) * 4;
+
+        if (memcmp (row_a, row_b, a_bounds.width * 4) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Blitting
+// -----------------------------------------------------------------------------
+
+// Turns the part of the region from (from_x, from_y) to (to_x, to_y), source
+// pixel (sx, sy) lands on (height - 1 - sy, sx)
+static void BlitRotatedScalar (uint32_t* dst, int dst_width, const uint32_t* src, int src_width, int height, int from_x, int from_y, int to_x, int to_y) {
+    for (int sy = from_y; sy < to_y; sy++) {
+        for (int sx = from_x; sx < to_x; sx++)
+            dst[(size_t)sx * dst_width + (height - 1 - sy)] = src[(size_t)sy * src_width + sx];
+    }
+}
+
+void RSP_BlitPixels (uint8_t* dst, int dst_width, int x, int y, const uint8_t* src, int src_width, RSP_PixelBounds bounds, bool rotated) {
+    const uint8_t* region = src + ((size_t)bounds.y * src_width + bounds.x) * 4;
+    uint8_t* target       = dst + ((size_t)y * dst_width + x) * 4;
+
+    if (!rotated) {
+        for (int row = 0; row < bounds.height; row++)
+            memcpy (target + (size_t)row * dst_width * 4, region + (size_t)row * src_width * 4, bounds.width * 4);
+
+        return;
+    }
+
+    // NOTE: Turning is done in 4x4 tiles, reading the source rows bottom up
+    // means the transposed tile comes out already in clockwise order. Whatever
+    // doesn't fill a whole tile is left to the scalar loop.
+    int tiled_width  = 0;
+    int tiled_height = 0;
+
+#ifdef __SSE2__
+    tiled_width  = bounds.width & ~3;
+    tiled_height = bounds.height & ~3;
+
+    for (int sy = 0; sy < tiled_height; sy += 4) {
+        for (int sx = 0; sx < tiled_width; sx += 4) {
+            const uint8_t* tile = region + ((size_t)sy * src_width + sx) * 4;
+
+            __m128i a0 = _mm_loadu_si128 ((const __m128i*)(tile + (size_t)3 * src_width * 4));
+            __m128i a1 = _mm_loadu_si128 ((const __m128i*)(tile + (size_t)2 * src_width * 4));
+            __m128i a2 = _mm_loadu_si128 ((const __m128i*)(tile + (size_t)1 * src_width * 4));
+            __m128i a3 = _mm_loadu_si128 ((const __m128i*)tile);
+
+            __m128i t0 = _mm_unpacklo_epi32 (a0, a1);
+            __m128i t1 = _mm_unpacklo_epi32 (a2, a3);
+            __m128i t2 = _mm_unpackhi_epi32 (a0, a1);
+            __m128i t3 = _mm_unpackhi_epi32 (a2, a3);
+
+            uint8_t* out = target + ((size_t)sx * dst_width + (bounds.height - 4 - sy)) * 4;
+
+            _mm_storeu_si128 ((__m128i*)out, _mm_unpacklo_epi64 (t0, t1));
+            _mm_storeu_si128 ((__m128i*)(out + (size_t)1 * dst_width * 4), _mm_unpackhi_epi64 (t0, t1));
+            _mm_storeu_si128 ((__m128i*)(out + (size_t)2 * dst_width * 4), _mm_unpacklo_epi64 (t2, t3));
+            _mm_storeu_si128 ((__m128i*)(out + (size_t)3 * dst_width * 4), _mm_unpackhi_epi64 (t2, t3));
+        }
+    }
+#endif
+
+    uint32_t* target_pixels       = (uint32_t*)target;
+    const uint32_t* region_pixels = (const uint32_t*)region;
+
+    BlitRotatedScalar (target_pixels, dst_width, region_pixels, src_width, bounds.height, tiled_width, 0, bounds.width, tiled_height);
+    BlitRotatedScalar (target_pixels, dst_width, region_pixels, src_width, bounds.height, 0, tiled_height, bounds.width, bounds.height);
+}
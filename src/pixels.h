@@ -0,0 +1,39 @@
+// -----------------------------------------------------------------------------
+// Pixels
+//
+// Helpers that work directly on 32-bit RGBA pixel data, kept free of raylib so
+// they can run without a window.
+// -----------------------------------------------------------------------------
+#ifndef RSP_PIXELS_H
+#define RSP_PIXELS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Type definitions
+// -----------------------------------------------------------------------------
+typedef struct RSP_PixelBounds {
+    int x;
+    int y;
+    int width;
+    int height;
+} RSP_PixelBounds;
+
+// -----------------------------------------------------------------------------
+// Function decleration
+// -----------------------------------------------------------------------------
+
+// Tight bounds of every pixel with a non zero alpha, a fully transparent image
+// gives a single pixel at the top left so it can still be packed
+RSP_PixelBounds RSP_GetOpaqueBounds (const uint8_t* pixels, int width, int height);
+
+// Hash and exact comparison of a region, width is the full row length in pixels
+uint64_t RSP_HashPixels (const uint8_t* pixels, int width, RSP_PixelBounds bounds);
+bool RSP_ComparePixels (const uint8_t* a, int a_width, RSP_PixelBounds a_bounds, const uint8_t* b, int b_width, RSP_PixelBounds b_bounds);
+
+// Copies a region of src into dst with its top left at x, y. Rotated regions
+// are turned clockwise so they cover height by width pixels, nothing is clipped
+void RSP_BlitPixels (uint8_t* dst, int dst_width, int x, int y, const uint8_t* src, int src_width, RSP_PixelBounds bounds, bool rotated);
+
+#endif // RSP_PIXELS_H
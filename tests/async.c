@@ -0,0 +1,119 @@
+// LoadBundleAsync against LoadBundle, pages have to be decoded on the worker
+// and only ever uploaded on the main thread from inside PollBundle
+#define RSP_IMPLEMENTATION
+#include <rsp.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "test.h"
+
+static pthread_t main_thread;
+
+static int polling = 0;
+static int uploads = 0;
+
+static int uploads_outside_poll = 0;
+static int uploads_off_main     = 0;
+
+static Texture2D MockUpload (Image image) {
+    uploads++;
+
+    uploads_outside_poll += !polling;
+    uploads_off_main += !pthread_equal (pthread_self (), main_thread);
+
+    return TestTexture (image, (unsigned int)uploads);
+}
+
+static void MockUnload (Texture2D texture) {
+    (void)texture;
+}
+
+// NOTE: Reads the job the same way PollBundle does, without taking anything
+static int IsJobFinished (const SpriteBundle* bundle) {
+    rsp__bundle_job* job = (rsp__bundle_job*)bundle->job;
+
+    pthread_mutex_lock (&job->lock);
+    const int finished = job->finished;
+    pthread_mutex_unlock (&job->lock);
+
+    return finished;
+}
+
+int main (int argc, const char* argv[]) {
+    if (argc < 2) {
+        fprintf (stderr, "Usage: %s <bundle>\n", argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel (LOG_WARNING);
+    SetPageUploadCallbacks (MockUpload, MockUnload);
+
+    main_thread = pthread_self ();
+
+    // NOTE: A failed load gets no id, unloading it mustn't free one up for
+    // the loads after it
+    SpriteBundle missing = LoadBundle ("missing.rspx");
+
+    CHECK (missing.id == 0);
+    UnloadBundle (missing);
+
+    SpriteBundle reference = LoadBundle (argv[1]);
+
+    CHECK (reference.id > 0);
+    CHECK (reference.sprites_count == 4);
+    CHECK (reference.pages_count == 3);
+    CHECK (uploads == 3);
+
+    uploads              = 0;
+    uploads_outside_poll = 0;
+
+    SpriteBundle bundle = LoadBundleAsync (argv[1]);
+
+    // NOTE: Nothing gets uploaded until polled, however far the worker is
+    CHECK (bundle.job != NULL);
+
+    while (bundle.job != NULL && !IsJobFinished (&bundle))
+        sched_yield ();
+
+    CHECK (uploads == 0);
+
+    // Every page was decoded before the first poll, so it uploads them all
+    polling    = 1;
+    int status = PollBundle (&bundle);
+    polling    = 0;
+
+    CHECK (uploads == 3);
+
+    while (status == 0) {
+        polling = 1;
+        status  = PollBundle (&bundle);
+        polling = 0;
+    }
+
+    CHECK (status == 1);
+    CHECK (uploads == 3);
+    CHECK (bundle.id > 0 && bundle.id != reference.id);
+    CHECK (uploads_outside_poll == 0);
+    CHECK (uploads_off_main == 0);
+
+    CHECK (bundle.job == NULL);
+    CHECK (bundle.sprites_count == reference.sprites_count);
+    CHECK (bundle.pages_count == reference.pages_count);
+
+    for (size_t i = 0; i < bundle.pages_count && i < reference.pages_count; i++) {
+        CHECK (bundle.pages[i].id != 0);
+        CHECK (bundle.pages[i].width == reference.pages[i].width);
+        CHECK (bundle.pages[i].height == reference.pages[i].height);
+    }
+
+    for (size_t i = 0; i < bundle.sprites_count && i < reference.sprites_count; i++) {
+        CHECK (memcmp (&bundle.sprites[i], &reference.sprites[i], sizeof (Sprite)) == 0);
+        CHECK (memcmp (&bundle.quads[i], &reference.quads[i], sizeof (SpriteQuad)) == 0);
+    }
+
+    UnloadBundle (bundle);
+    UnloadBundle (reference);
+
+    return TestResult ("async");
+}
@@ -0,0 +1,104 @@
+// Deferred pages under a budget, pages are only uploaded once used and the
+// one used longest ago is unloaded to make room
+#define RSP_IMPLEMENTATION
+#include <rsp.h>
+
+#include "test.h"
+
+static int uploads = 0;
+static int unloads = 0;
+
+static unsigned int last_unloaded = 0;
+
+static Texture2D MockUpload (Image image) {
+    uploads++;
+
+    return TestTexture (image, (unsigned int)uploads);
+}
+
+static void MockUnload (Texture2D texture) {
+    unloads++;
+    last_unloaded = texture.id;
+}
+
+// Resolves the sprite the same way drawing it would, returns its texture
+static unsigned int UseSprite (const char* name) {
+    const SpriteInstance instance = {GetSpriteId (name), {0.0f, 0.0f}, {1.0f, 1.0f}, 0.0f, WHITE};
+    unsigned int texture          = 0;
+
+    GetSpriteTextures (&instance, 1, &texture);
+
+    return texture;
+}
+
+int main (int argc, const char* argv[]) {
+    if (argc < 2) {
+        fprintf (stderr, "Usage: %s <bundle>\n", argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel (LOG_WARNING);
+    SetPageUploadCallbacks (MockUpload, MockUnload);
+
+    SpriteBundle bundle = LoadBundleDeferred (argv[1]);
+    SetActiveBundle (&bundle);
+
+    CHECK (bundle.id > 0);
+    CHECK (bundle.pages_count == 3);
+    CHECK (uploads == 0);
+    CHECK (GetPageMemoryUsed () == 0);
+
+    // NOTE: Red, green & blue are each big enough to need a page of their own
+    const size_t page_bytes = 64 * 64 * 4;
+
+    SetPageBudget (page_bytes * 2);
+
+    const unsigned int red   = UseSprite ("red");
+    const unsigned int green = UseSprite ("green");
+
+    CHECK (red != 0 && green != 0 && red != green);
+    CHECK (uploads == 2);
+    CHECK (GetPageMemoryUsed () == page_bytes * 2);
+
+    // Already resident, nothing changes
+    CHECK (UseSprite ("red") == red);
+    CHECK (uploads == 2);
+
+    // NOTE: Green was used longest ago now, so it makes room for blue
+    const unsigned int blue = UseSprite ("blue");
+
+    CHECK (blue != 0);
+    CHECK (uploads == 3);
+    CHECK (unloads == 1);
+    CHECK (last_unloaded == green);
+    CHECK (GetPageMemoryUsed () == page_bytes * 2);
+
+    // Green comes back in place of red
+    CHECK (UseSprite ("green") != 0);
+    CHECK (uploads == 4);
+    CHECK (unloads == 2);
+    CHECK (last_unloaded == red);
+    CHECK (GetPageMemoryUsed () == page_bytes * 2);
+
+    // Lowering the budget unloads straight away, no limit lets everything in
+    SetPageBudget (page_bytes);
+
+    CHECK (unloads == 3);
+    CHECK (last_unloaded == blue);
+    CHECK (GetPageMemoryUsed () == page_bytes);
+
+    SetPageBudget (0);
+
+    CHECK (UseSprite ("red") != 0);
+    CHECK (UseSprite ("blue") != 0);
+    CHECK (unloads == 3);
+    CHECK (GetPageMemoryUsed () == page_bytes * 3);
+
+    SetActiveBundle (NULL);
+    UnloadBundle (bundle);
+
+    CHECK (unloads == uploads);
+    CHECK (GetPageMemoryUsed () == 0);
+
+    return TestResult ("residency");
+}
@@ -0,0 +1,38 @@
+#ifndef RSP_TEST_H
+#define RSP_TEST_H
+
+#include <math.h>
+#include <stdio.h>
+
+// NOTE: Tests run without a window, pages go through counting callbacks so
+// nothing ever touches the GPU. Each one takes the bundle built from
+// tests/data/project.rspp as its only argument, see `make test`
+
+static int test_checks   = 0;
+static int test_failures = 0;
+
+static void TestCheck (int passed, const char* condition, const char* file, int line) {
+    test_checks++;
+
+    if (!passed) {
+        test_failures++;
+        fprintf (stderr, "%s:%d: CHECK (%s) failed\n", file, line, condition);
+    }
+}
+
+#define CHECK(condition)  TestCheck ((condition) != 0, #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b)  TestCheck (fabsf ((a) - (b)) < 0.001f, #a " == " #b, __FILE__, __LINE__)
+
+// Prints how it went and gives the exit code
+static int TestResult (const char* name) {
+    printf ("%s: %d of %d checks passed\n", name, test_checks - test_failures, test_checks);
+
+    return test_failures > 0;
+}
+
+// What the mock uploads hand back, sized like the image so the budget works
+static Texture2D TestTexture (Image image, unsigned int id) {
+    return (Texture2D){id, image.width, image.height, image.mipmaps, image.format};
+}
+
+#endif // RSP_TEST_H
@@ -0,0 +1,184 @@
+// GenSpriteVertices on a deferred bundle, vertices & texture coordinates have
+// to come out of the bundle's tables alone with no page ever uploaded
+#define RSP_IMPLEMENTATION
+#include <rsp.h>
+
+#include "test.h"
+
+static int uploads = 0;
+
+static Texture2D MockUpload (Image image) {
+    uploads++;
+
+    return TestTexture (image, (unsigned int)uploads);
+}
+
+static void MockUnload (Texture2D texture) {
+    (void)texture;
+}
+
+static void CheckCorner (SpriteVertex vertex, float x, float y) {
+    CHECK_NEAR (vertex.position.x, x);
+    CHECK_NEAR (vertex.position.y, y);
+}
+
+int main (int argc, const char* argv[]) {
+    if (argc < 2) {
+        fprintf (stderr, "Usage: %s <bundle>\n", argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel (LOG_WARNING);
+    SetPageUploadCallbacks (MockUpload, MockUnload);
+
+    SpriteBundle bundle = LoadBundleDeferred (argv[1]);
+    SetActiveBundle (&bundle);
+
+    CHECK (bundle.id > 0);
+
+    const int red = GetSpriteId ("red");
+    const int dot = GetSpriteId ("dot");
+
+    CHECK (red >= 0);
+    CHECK (dot >= 0);
+
+    const Color tint = {10, 20, 30, 40};
+
+    const SpriteInstance instances[] = {
+        {red, {100.0f, 50.0f}, {1.0f, 1.0f}, 0.0f, tint},
+        {red, {100.0f, 50.0f}, {2.0f, 2.0f}, 0.0f, tint},
+        {red, {100.0f, 50.0f}, {1.0f, 1.0f}, 90.0f, tint},
+        {dot, {0.0f, 0.0f}, {1.0f, 1.0f}, 0.0f, tint},
+        {RSP_SPRITE_ID (3, 0), {1.0f, 1.0f}, {1.0f, 1.0f}, 0.0f, tint},
+    };
+
+    SpriteVertex vertices[5 * 4];
+    GenSpriteVertices (instances, 5, vertices);
+
+    CHECK (uploads == 0);
+
+    // NOTE: Top left, bottom left, bottom right then top right around the
+    // origin at 24, 24
+    CheckCorner (vertices[0], 76.0f, 26.0f);
+    CheckCorner (vertices[1], 76.0f, 74.0f);
+    CheckCorner (vertices[2], 124.0f, 74.0f);
+    CheckCorner (vertices[3], 124.0f, 26.0f);
+
+    CheckCorner (vertices[4], 52.0f, 2.0f);
+    CheckCorner (vertices[6], 148.0f, 98.0f);
+
+    CheckCorner (vertices[8], 124.0f, 26.0f);
+    CheckCorner (vertices[9], 76.0f, 26.0f);
+    CheckCorner (vertices[10], 76.0f, 74.0f);
+    CheckCorner (vertices[11], 124.0f, 74.0f);
+
+    CheckCorner (vertices[12], -4.0f, -4.0f);
+    CheckCorner (vertices[14], 4.0f, 4.0f);
+
+    // NOTE: Pages are 64x64, see tests/data/project.rspp
+    const Sprite* sprite = &bundle.sprites[RSP_SPRITE_INDEX (red)];
+
+    CHECK (bundle.page_sizes[sprite->page].x == 64.0f);
+    CHECK (bundle.page_sizes[sprite->page].y == 64.0f);
+
+    CHECK_NEAR (vertices[0].texcoord.x, sprite->source.x / 64.0f);
+    CHECK_NEAR (vertices[0].texcoord.y, sprite->source.y / 64.0f);
+    CHECK_NEAR (vertices[2].texcoord.x, (sprite->source.x + 48.0f) / 64.0f);
+    CHECK_NEAR (vertices[2].texcoord.y, (sprite->source.y + 48.0f) / 64.0f);
+
+    CHECK (memcmp (&vertices[0].colour, &tint, sizeof (Color)) == 0);
+    CHECK (memcmp (&vertices[15].colour, &tint, sizeof (Color)) == 0);
+
+    // NOTE: No bundle in slot 3, zeroed so it draws nothing
+    const SpriteVertex zero = {0};
+    for (int i = 16; i < 20; i++)
+        CHECK (memcmp (&vertices[i], &zero, sizeof (SpriteVertex)) == 0);
+
+    // Resolving is what loads pages, only the ones actually used
+    unsigned int textures[5];
+    GetSpriteTextures (instances, 5, textures);
+
+    CHECK (textures[0] != 0);
+    CHECK (textures[0] == textures[1] && textures[1] == textures[2]);
+    CHECK (textures[4] == 0);
+    CHECK (uploads == 1 + (bundle.sprites[RSP_SPRITE_INDEX (dot)].page != bundle.sprites[RSP_SPRITE_INDEX (red)].page));
+
+    // NOTE: The editor can't make frames yet, so dot is turned into an
+    // animation here with a copy of the tables. Flags are spelled out since
+    // rsp.h undefines them once it is done
+    Sprite sprites[4];
+    memcpy (sprites, bundle.sprites, sizeof (sprites));
+
+    Sprite* const bundle_sprites   = bundle.sprites;
+    Rectangle* const bundle_frames = bundle.frames;
+    const uint32_t frames_count    = bundle.frames_count;
+    Sprite* animated               = &sprites[RSP_SPRITE_INDEX (dot)];
+    Rectangle frames[2]            = {animated->source, {animated->source.x, animated->source.y, 4.0f, 8.0f}};
+
+    animated->flags |= 1 << 0; // RSP_SPRITE_ANIMATED
+    animated->animation.frames_index = 0;
+    animated->animation.frames_count = 2;
+
+    bundle.sprites      = sprites;
+    bundle.frames       = frames;
+    bundle.frames_count = 2;
+
+    const int animation = PlayAnimation (dot, 1.0f, ANIMATION_LOOP);
+    CHECK (animation >= 0);
+
+    // Untrimmed, the first frame is the sprite itself
+    SpriteVertex frame_vertices[4];
+    GenAnimationVertices (animation, instances[3].position, instances[3].scale, 0.0f, tint, frame_vertices);
+
+    for (int i = 0; i < 4; i++) {
+        CheckCorner (frame_vertices[i], vertices[12 + i].position.x, vertices[12 + i].position.y);
+        CHECK_NEAR (frame_vertices[i].texcoord.x, vertices[12 + i].texcoord.x);
+        CHECK_NEAR (frame_vertices[i].texcoord.y, vertices[12 + i].texcoord.y);
+    }
+
+    // NOTE: Frames are never trimmed, so trimming the sprite leaves them
+    // around the origin at 4, 4
+    animated->offset = (Vector2){2.0f, 3.0f};
+    GenAnimationVertices (animation, instances[3].position, instances[3].scale, 0.0f, tint, frame_vertices);
+
+    CheckCorner (frame_vertices[0], -4.0f, -4.0f);
+    CheckCorner (frame_vertices[2], 4.0f, 4.0f);
+
+    // Frames of rotated sprites turn back the same way the sprite does
+    animated->offset = (Vector2){0.0f, 0.0f};
+    animated->flags |= 1 << 2; // RSP_SPRITE_ROTATED
+    bundle.quads[RSP_SPRITE_INDEX (dot)].flags |= 1 << 2;
+
+    GenSpriteVertices (&instances[3], 1, &vertices[12]);
+    GenAnimationVertices (animation, instances[3].position, instances[3].scale, 0.0f, tint, frame_vertices);
+
+    for (int i = 0; i < 4; i++)
+        CheckCorner (frame_vertices[i], vertices[12 + i].position.x, vertices[12 + i].position.y);
+
+    // A 4x8 frame stored turned is drawn 8 wide & 4 tall
+    UpdateAnimations (1.5f / RSP_ANIMATION_FPS);
+    CHECK (GetAnimationFrame (animation) == 1);
+
+    GenAnimationVertices (animation, instances[3].position, instances[3].scale, 0.0f, tint, frame_vertices);
+
+    CHECK_NEAR (fabsf (frame_vertices[2].position.x - frame_vertices[0].position.x), 8.0f);
+    CHECK_NEAR (fabsf (frame_vertices[2].position.y - frame_vertices[0].position.y), 4.0f);
+
+    // Not playing, nothing to draw
+    StopAnimation (animation);
+    GenAnimationVertices (animation, instances[3].position, instances[3].scale, 0.0f, tint, frame_vertices);
+
+    for (int i = 0; i < 4; i++)
+        CHECK (memcmp (&frame_vertices[i], &zero, sizeof (SpriteVertex)) == 0);
+
+    StopAllAnimations ();
+
+    bundle.sprites      = bundle_sprites;
+    bundle.frames       = bundle_frames;
+    bundle.frames_count = frames_count;
+
+    SetActiveBundle (NULL);
+    UnloadBundle (bundle);
+
+    return TestResult ("vertices");
+}